@@ -0,0 +1,456 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// headless batch halftoning: every image found in the inputs is processed with the same
+/// parameters, several at a time, and written next to its relative path below the output
+/// directory.
+
+
+#include "core/eh.hpp"
+#include "core/Export.hpp"
+#include "core/PointSet.hpp"
+#include "core/TiledHalftoning.hpp"
+#include "core/ThreadPool.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <thread>
+
+
+using namespace core;
+
+namespace
+{
+    struct Job
+    {
+        QString input;
+        QString output; ///< path of the results without a suffix.
+    };
+
+    struct Options
+    {
+        i32 particles{1024*4};
+        i32 iterations{16};
+        f32 radius{1};
+        Repulsion repulsion{Repulsion::Exact};
+        ForceFieldMethod field{ForceFieldMethod::Fft};
+        Precision fieldPrecision{Precision::Double};
+        Precision repulsionPrecision{Precision::Float};
+        f32 theta{0.5};
+        u64 seed{0};
+        f32 tolerance{0};
+        bool svg{true};
+        QString svgSuffix{".svg"};
+        SvgStyle svgStyle{SvgStyle::Circles};
+        bool points{false};
+        qreal scale{1};
+        qreal dotRadius{1};
+        std::shared_ptr<const ForceFieldCache> cache; ///< shared by every job, nullptr disables it.
+        i32 checkpointInterval{0};
+        bool resume{false};
+        Tiling tiling{0};   ///< a tile size of 0 halftones every image as a whole.
+        std::shared_ptr<Profiler> profiler; ///< shared by every job, nullptr disables profiling.
+    };
+
+    /// one job per image; images inside a directory keep their path relative to it.
+    std::vector<Job> collectJobs(const QStringList& inputs, const QDir& output)
+    {
+        QStringList filters;
+        for (const auto& format : QImageReader::supportedImageFormats()) {
+            filters << "*." + QString::fromLatin1(format);
+        }
+        filters << "*.ehp";
+
+        std::vector<Job> jobs;
+        for (const auto& input : inputs) {
+            const QFileInfo info(input);
+            if (info.isDir()) {
+                const QDir dir(info.absoluteFilePath());
+                QDirIterator it(dir.path(), filters, QDir::Files, QDirIterator::Subdirectories);
+                while (it.hasNext()) {
+                    const QFileInfo file(it.next());
+                    const auto relative = dir.relativeFilePath(file.absolutePath());
+                    jobs.push_back({file.absoluteFilePath(),
+                                    output.filePath(QDir::cleanPath(relative + '/' + file.completeBaseName()))});
+                }
+            } else {
+                jobs.push_back({info.absoluteFilePath(), output.filePath(info.completeBaseName())});
+            }
+        }
+
+        std::ranges::sort(jobs, {}, &Job::input);
+        return jobs;
+    }
+
+    struct Result
+    {
+        i32 iterations{0};
+        Precision fieldPrecision{};     ///< as used, see ElectrostaticHalftoning::precision.
+        Precision repulsionPrecision{};
+        bool loaded{false};             ///< exported from a point set, nothing was run.
+        f32 seamSpacing{0};             ///< of a tiled run, see TiledResult.
+        f32 interiorSpacing{0};
+    };
+
+    std::optional<Precision> parsePrecision(const QString& name)
+    {
+        for (auto precision : {Precision::Float, Precision::Mixed, Precision::Double}) {
+            if (name.toLower().toStdString() == toString(precision)) {
+                return precision;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// writes the requested formats of frame, whose points lie on an image of size.
+    void writeOutputs(const Job& job, const Options& options, const PointFrame& frame, const QSize& size)
+    {
+        if (options.svg && !writeSvg(job.output + options.svgSuffix, frame, size, options.scale,
+                                     options.dotRadius, options.svgStyle)) {
+            throw std::runtime_error("cannot write " + (job.output + options.svgSuffix).toStdString());
+        }
+        if (options.points && !writePoints(job.output + ".txt", frame)) {
+            throw std::runtime_error("cannot write " + (job.output + ".txt").toStdString());
+        }
+    }
+
+    /// halftones one image on its own backend, devices are shared by all jobs; a point set
+    /// (*.ehp) is exported as it is.
+    Result process(const Job& job, const Options& options, const std::vector<std::shared_ptr<Device>>& devices,
+                   u32 threads)
+    {
+        if (!QDir().mkpath(QFileInfo(job.output).absolutePath())) {
+            throw std::runtime_error("cannot create the output directory");
+        }
+
+        if (job.input.endsWith(".ehp", Qt::CaseInsensitive)) {
+            const auto set = PointSet::load(job.input);
+            if (!set) {
+                throw std::runtime_error("cannot read point set");
+            }
+            const auto& info = set->info();
+            writeOutputs(job, options, set->frame(), QSize(info.width, info.height));
+            return {info.iteration, {}, {}, true};
+        }
+
+        ElectrostaticHalftoning eh(createBackend(devices, threads));
+        eh.setForceFieldCache(options.cache);
+        eh.setParticleCount(options.particles);
+        eh.setParticleRadius(options.radius);
+        eh.setMaxIteration(options.iterations);
+        eh.setRepulsion(options.repulsion);
+        eh.setOpeningAngle(options.theta);
+        eh.setForceFieldMethod(options.field);
+        eh.setPrecision(Stage::ForceField, options.fieldPrecision);
+        eh.setPrecision(Stage::Repulsion, options.repulsionPrecision);
+        eh.setSeed(options.seed);
+        eh.setTolerance(options.tolerance);
+        eh.setReadbackInterval(0);
+        if (options.profiler) {
+            eh.setProfiler(options.profiler);
+        }
+
+        if (options.tiling.tileSize > 0) {
+            if (const auto error = tilingError(job.input)) {
+                throw std::runtime_error(*error);
+            }
+            const auto result = halftoneTiled(eh, job.input, options.particles, options.tiling);
+            if (!result) {
+                throw std::runtime_error("cannot read image");
+            }
+            writeOutputs(job, options, result->points, result->size);
+            return {result->iterations, eh.precision(Stage::ForceField), eh.precision(Stage::Repulsion), false,
+                    result->seamSpacing, result->interiorSpacing};
+        }
+
+        const QImage image(job.input);
+        if (image.isNull()) {
+            throw std::runtime_error("cannot read image");
+        }
+        eh.setValues(normalizedValues(image), image.width(), image.height());
+
+        const auto checkpoint = job.output + ".ehp";
+        if (options.resume) {
+            if (const auto set = PointSet::load(checkpoint); set && !eh.resume(*set)) {
+                throw std::runtime_error("the checkpoint " + checkpoint.toStdString() + " is of another image");
+            }
+        }
+        eh.setCheckpoint(checkpoint, options.checkpointInterval);
+        eh.run();
+
+        writeOutputs(job, options, eh.points(), image.size());
+
+        return {eh.currentIteration(), eh.precision(Stage::ForceField), eh.precision(Stage::Repulsion)};
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ElectrostaticHalftoningBatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Electrostatic halftoning of many images without the GUI.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "image files, point sets (*.ehp) to export, or directories, searched "
+                                 "recursively.", "inputs...");
+
+    const QCommandLineOption outputOption({"o", "output"}, "output directory.", "dir", ".");
+    const QCommandLineOption particlesOption({"n", "particles"}, "particle count.", "count", "4096");
+    const QCommandLineOption radiusOption({"r", "radius"}, "particle radius.", "radius", "1");
+    const QCommandLineOption iterationsOption({"i", "iterations"}, "iteration count.", "count", "16");
+    const QCommandLineOption toleranceOption({"t", "tolerance"}, "stop once no particle moves more than this many "
+                                             "pixels in an iteration (default: 0, run every iteration).", "pixels", "0");
+    const QCommandLineOption repulsionOption("repulsion", "exact, tiled, barnes-hut or p3m.", "method", "exact");
+    const QCommandLineOption precisionOption("precision", "float, mixed or double sums of the repulsion.",
+                                             "precision", "float");
+    const QCommandLineOption fieldOption("field", "force field method, fft or direct.", "method", "fft");
+    const QCommandLineOption fieldPrecisionOption("field-precision", "float, mixed or double sums of the direct "
+                                                  "force field; double falls back to mixed on devices without it.",
+                                                  "precision", "double");
+    const QCommandLineOption thetaOption("theta", "Barnes-Hut opening angle.", "theta", "0.5");
+    const QCommandLineOption seedOption("seed", "random seed; equal seeds give equal results.", "seed", "0");
+    const QCommandLineOption formatOption({"f", "format"}, "svg, points or both.", "format", "svg");
+    const QCommandLineOption compressOption({"z", "compress"}, "write gzip-compressed .svgz files.");
+    const QCommandLineOption svgStyleOption("svg-style", "circles, or path for about half the size.", "style", "circles");
+    const QCommandLineOption scaleOption("scale", "SVG scale.", "scale", "1");
+    const QCommandLineOption dotRadiusOption("dot-radius", "SVG dot radius.", "radius", "1");
+    const QCommandLineOption backendOption("backend", "auto, opencl, native, or all to share the particles "
+                                           "between every OpenCL device.", "backend", "auto");
+    const QCommandLineOption cacheOption("cache", "force field cache directory (default: the user's cache).", "dir");
+    const QCommandLineOption noCacheOption("no-cache", "neither read nor write cached force fields.");
+    const QCommandLineOption cacheSizeOption("cache-size", "keep the force field cache below this many MiB by "
+                                             "removing the least recently used fields (default: 2048, 0: no "
+                                             "limit).", "MiB", "2048");
+    const QCommandLineOption checkpointOption("checkpoint", "write the particles to <output>.ehp every this many "
+                                              "iterations and after the last one (default: 0, never).", "iterations", "0");
+    const QCommandLineOption resumeOption("resume", "continue from <output>.ehp where there is one.");
+    const QCommandLineOption tileOption("tile", "halftone images in tiles of up to this many pixels square, for images "
+                                        "too large for the device (default: 0, whole images).", "pixels", "0");
+    const QCommandLineOption haloOption("halo", "pixels around a tile simulated with it (default: 128).", "pixels",
+                                        "128");
+    const QCommandLineOption autotuneOption("autotune", "time candidate work-group sizes of every kernel the "
+                                            "device has no tuned ones for yet, and keep the fastest for later runs.");
+    const QCommandLineOption profileOption("profile", "time every kernel, transfer and host stage, print the totals "
+                                           "and write a Chrome trace to this file.", "trace.json");
+    const QCommandLineOption jobsOption({"j", "jobs"}, "images processed at the same time (default: 4 with OpenCL, "
+                                        "one per hardware thread otherwise).", "count", "0");
+
+    parser.addOptions({outputOption, particlesOption, radiusOption, iterationsOption, toleranceOption, repulsionOption,
+                       precisionOption, fieldOption, fieldPrecisionOption, thetaOption, seedOption, formatOption,
+                       compressOption, svgStyleOption, scaleOption, dotRadiusOption, cacheOption, noCacheOption,
+                       cacheSizeOption, checkpointOption, resumeOption, tileOption, haloOption, backendOption,
+                       autotuneOption, profileOption, jobsOption});
+    parser.process(app);
+
+    auto fail = [](const std::string& message) {
+        std::println(stderr, "error: {}", message);
+        return 2;
+    };
+
+    Options options;
+    options.particles  = parser.value(particlesOption).toInt();
+    options.iterations = parser.value(iterationsOption).toInt();
+    options.radius     = parser.value(radiusOption).toFloat();
+    options.theta      = parser.value(thetaOption).toFloat();
+    options.seed       = parser.value(seedOption).toULongLong();
+    options.tolerance  = parser.value(toleranceOption).toFloat();
+    options.scale      = parser.value(scaleOption).toDouble();
+    options.dotRadius  = parser.value(dotRadiusOption).toDouble();
+    options.resume     = parser.isSet(resumeOption);
+    options.checkpointInterval = parser.value(checkpointOption).toInt();
+    options.tiling.tileSize    = parser.value(tileOption).toUInt();
+    options.tiling.halo        = parser.value(haloOption).toUInt();
+
+    if (parser.isSet(profileOption)) {
+        options.profiler = std::make_shared<Profiler>();
+    }
+
+    if (!parser.isSet(noCacheOption)) {
+        options.cache = std::make_shared<ForceFieldCache>(parser.value(cacheOption),
+                                                          parser.value(cacheSizeOption).toLongLong() << 20);
+    }
+
+    if (options.particles < 1 || options.iterations < 1 || !(options.radius > 0)) {
+        return fail("particles, iterations and radius must be positive");
+    }
+
+    if (options.tiling.tileSize > 0) {
+        if (options.checkpointInterval > 0 || options.resume) {
+            return fail("tiled images cannot be checkpointed");
+        }
+        /// poster-size images exceed Qt's default limit when a format has to be decoded whole;
+        /// halftoneTiled refuses those above maxDecodedPixels, of 4 bytes at most.
+        QImageReader::setAllocationLimit(int(maxDecodedPixels * 4 >> 20));
+    }
+
+    if (const auto method = parser.value(repulsionOption).toLower(); method == "exact") {
+        options.repulsion = Repulsion::Exact;
+    } else if (method == "tiled") {
+        options.repulsion = Repulsion::Tiled;
+    } else if (method == "barnes-hut") {
+        options.repulsion = Repulsion::BarnesHut;
+    } else if (method == "p3m") {
+        options.repulsion = Repulsion::P3M;
+    } else {
+        return fail("unknown repulsion method " + method.toStdString());
+    }
+
+    if (const auto method = parser.value(fieldOption).toLower(); method == "direct") {
+        options.field = ForceFieldMethod::Direct;
+    } else if (method != "fft") {
+        return fail("unknown force field method " + method.toStdString());
+    }
+
+    if (const auto precision = parsePrecision(parser.value(precisionOption))) {
+        options.repulsionPrecision = *precision;
+    } else {
+        return fail("unknown precision " + parser.value(precisionOption).toStdString());
+    }
+
+    if (const auto precision = parsePrecision(parser.value(fieldPrecisionOption))) {
+        options.fieldPrecision = *precision;
+    } else {
+        return fail("unknown precision " + parser.value(fieldPrecisionOption).toStdString());
+    }
+
+    if (const auto format = parser.value(formatOption).toLower(); format == "svg" || format == "both") {
+        options.points = format == "both";
+    } else if (format == "points") {
+        options.svg    = false;
+        options.points = true;
+    } else {
+        return fail("unknown format " + format.toStdString());
+    }
+
+    if (parser.isSet(compressOption)) {
+        options.svgSuffix = ".svgz";
+    }
+
+    if (const auto style = parser.value(svgStyleOption).toLower(); style == "path") {
+        options.svgStyle = SvgStyle::Path;
+    } else if (style != "circles") {
+        return fail("unknown SVG style " + style.toStdString());
+    }
+
+    auto type = BackendType::Auto;
+    if (const auto backend = parser.value(backendOption).toLower(); backend == "opencl") {
+        type = BackendType::OpenCL;
+    } else if (backend == "native") {
+        type = BackendType::Native;
+    } else if (backend == "all") {
+        type = BackendType::AllDevices;
+    } else if (backend != "auto") {
+        return fail("unknown backend " + backend.toStdString());
+    }
+
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(2);
+    }
+
+    const auto jobs = collectJobs(parser.positionalArguments(), QDir(parser.value(outputOption)));
+    if (jobs.empty()) {
+        return fail("no images found");
+    }
+
+    /// one context and one built program per device serve every job; each job gets its own queues.
+    std::vector<std::shared_ptr<Device>> devices;
+    try {
+        devices = selectDevices(type);
+    } catch (const std::exception& e) {
+        return fail(std::string("OpenCL: ") + e.what());
+    }
+    if (parser.isSet(autotuneOption)) {
+        for (const auto& device : devices) {
+            device->setAutotune(true);
+        }
+    }
+
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    auto workers = parser.value(jobsOption).toUInt();
+    if (workers == 0) {
+        workers = !devices.empty() ? std::min(4u, hardware) : hardware;
+    }
+    workers = std::min<u32>(workers, jobs.size());
+
+    /// native jobs split the hardware threads between them.
+    const auto threadsPerJob = std::max(1u, hardware / workers);
+
+    std::string names;
+    for (const auto& device : devices) {
+        names += (names.empty() ? "" : " + ") + device->device().name();
+    }
+    std::println("{} images, {} at a time, on {}", jobs.size(), workers,
+                 !devices.empty() ? "OpenCL (" + names + ")" : std::string("the native backend"));
+
+    std::mutex printMutex;
+    std::atomic<u32> finished{0};
+    std::atomic<u32> failed{0};
+
+    ThreadPool pool(workers);
+    pool.parallelFor(jobs.size(), [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            std::string error;
+            Result result;
+            try {
+                result = process(jobs[i], options, devices, threadsPerJob);
+            } catch (const std::exception& e) {
+                error = e.what();
+                failed++;
+            }
+
+            const auto done = ++finished;
+            std::lock_guard lock(printMutex);
+            if (error.empty() && result.loaded) {
+                std::println("[{}/{}] {} (point set of iteration {})", done, jobs.size(), jobs[i].input.toStdString(),
+                             result.iterations);
+            } else if (error.empty()) {
+                std::println("[{}/{}] {} ({} iterations, {} force field, {} repulsion)", done, jobs.size(),
+                             jobs[i].input.toStdString(), result.iterations, toString(result.fieldPrecision),
+                             toString(result.repulsionPrecision));
+                if (result.seamSpacing > 0) {
+                    std::println("    nearest neighbour {:.3f} px at tile edges, {:.3f} px inside tiles",
+                                 result.seamSpacing, result.interiorSpacing);
+                }
+            } else {
+                std::println(stderr, "[{}/{}] {}: {}", done, jobs.size(), jobs[i].input.toStdString(), error);
+            }
+        }
+    });
+
+    if (options.profiler) {
+        std::println("{:<24} {:>8} {:>10} {:>12} {:>12} {:>12}", "stage", "kind", "count", "total ms", "mean us",
+                     "queued us");
+        for (const auto& stage : options.profiler->stages()) {
+            const auto count = f64(std::max<u64>(1, stage.count));
+            std::println("{:<24} {:>8} {:>10} {:>12.2f} {:>12.2f} {:>12.2f}", stage.name, toString(stage.category),
+                         stage.count, f64(stage.total) / 1e6, f64(stage.total) / 1e3 / count,
+                         f64(stage.waited) / 1e3 / count);
+        }
+        if (const auto path = parser.value(profileOption); !options.profiler->writeTrace(path)) {
+            std::println(stderr, "cannot write {}", path.toStdString());
+        }
+    }
+
+    if (failed > 0) {
+        std::println(stderr, "{} of {} images failed", u32(failed), jobs.size());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,425 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// benchmarks every stage of the pipeline over a matrix of image sizes and particle counts,
+/// and writes one record per stage and case as JSON or CSV, so builds and machines can be
+/// compared and regressions caught before they ship.
+///
+/// the stages are named after what ElectrostaticHalftoning runs them from; the ones below the
+/// image work on the backend directly, so that each is timed on its own.
+
+
+#include "core/eh.hpp"
+#include "core/Export.hpp"
+#include "gui/SplatRenderer.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <print>
+#include <vector>
+
+
+using namespace core;
+
+namespace
+{
+    struct Options
+    {
+        std::vector<u32> sizes;
+        std::vector<u32> particles;
+        f64 minTime{0.25};          ///< seconds each case is repeated for, at least once.
+        u32 maxRuns{20};
+        f64 maxPairs{f64(1ull << 34)}; ///< cases with more pairwise interactions are skipped.
+    };
+
+    struct Record
+    {
+        QString stage;
+        u32 size{0};       ///< side of the square image.
+        u32 particles{0};  ///< 0 where the stage does not depend on them.
+        u32 runs{0};
+        f64 seconds{0};    ///< median of one run.
+        f64 work{0};       ///< items one run processes, in unit.
+        QString unit;
+
+        f64 throughput() const { return seconds > 0 ? work / seconds : 0; }
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /// times run, which must wait for everything it starts, after one warm-up call; repeated
+    /// until minTime has passed or maxRuns are done.
+    std::pair<f64, u32> measure(const Options& options, const std::function<void()>& run)
+    {
+        auto seconds = [](Clock::time_point from) {
+            return std::chrono::duration<f64>(Clock::now() - from).count();
+        };
+
+        const auto warmStart = Clock::now();
+        run();
+        const auto warm = seconds(warmStart);
+
+        const auto runs = u32(std::clamp(options.minTime / std::max(warm, 1e-9), 1.0, f64(options.maxRuns)));
+        std::vector<f64> times;
+        for (u32 i = 0; i < runs; ++i) {
+            const auto start = Clock::now();
+            run();
+            times.push_back(seconds(start));
+        }
+
+        std::ranges::nth_element(times, times.begin() + times.size() / 2);
+        return {times[times.size() / 2], runs};
+    }
+
+    /// a smooth gradient with rings and a dark disc, so that every density occurs.
+    QImage testImage(u32 size)
+    {
+        QImage image(size, size, QImage::Format_Grayscale8);
+        for (u32 row = 0; row < size; ++row) {
+            auto* line = image.scanLine(row);
+            for (u32 col = 0; col < size; ++col) {
+                const auto x = (col + 0.5) / size - 0.5;
+                const auto y = (row + 0.5) / size - 0.5;
+                const auto r = std::hypot(x, y);
+                auto v = 0.5 + 0.35 * std::cos(24 * r) * (col + 0.5) / size;
+                if (r < 0.15) {
+                    v *= 0.2;
+                }
+                line[col] = uchar(std::clamp(v, 0.0, 1.0) * 255);
+            }
+        }
+        return image;
+    }
+
+    std::vector<u32> parseList(const QString& text)
+    {
+        std::vector<u32> values;
+        for (const auto& item : text.split(',', Qt::SkipEmptyParts)) {
+            const auto value = item.trimmed().toUInt();
+            if (value > 0) {
+                values.push_back(value);
+            }
+        }
+        return values;
+    }
+
+    class Suite
+    {
+    public:
+        Suite(const Options& options, Backend& backend, const QString& scratch)
+            : _options(options)
+            , _backend(backend)
+            , _scratch(scratch)
+        {
+        }
+
+        const std::vector<Record>& records() const { return _records; }
+
+        void run()
+        {
+            for (const auto size : _options.sizes) {
+                runImage(size);
+                for (const auto n : _options.particles) {
+                    runParticles(size, n);
+                }
+            }
+        }
+
+    private:
+        void add(const QString& stage, u32 size, u32 particles, f64 work, const QString& unit,
+                 const std::function<void()>& run)
+        {
+            const auto [seconds, runs] = measure(_options, run);
+            _records.push_back({stage, size, particles, runs, seconds, work, unit});
+
+            const auto& record = _records.back();
+            std::println(stderr, "{:<28} {:>5}px {:>8} particles {:>12.6f} s {:>12.4g} {}/s", stage.toStdString(),
+                         size, particles, seconds, record.throughput(), unit.toStdString());
+        }
+
+        void skip(const QString& stage, u32 size, u32 particles)
+        {
+            std::println(stderr, "{:<28} {:>5}px {:>8} particles skipped, over --max-pairs", stage.toStdString(),
+                         size, particles);
+        }
+
+        /// waits for the backend to finish the stage, so that its time includes no readback.
+        void sync()
+        {
+            _backend.finish();
+        }
+
+        void runImage(u32 size)
+        {
+            const auto image  = testImage(size);
+            const auto pixels = f64(size) * size;
+
+            add("normalizedValues", size, 0, pixels, "pixels", [&] {
+                _values = normalizedValues(image);
+            });
+
+            auto charges = std::vector<f32>(_values.size());
+            std::ranges::transform(_values, charges.begin(), [](auto x) { return 1.f - x; });
+
+            FieldConvolution convolution{coulomb};
+            add("computeForceField/fft", size, 0, pixels, "pixels", [&] {
+                _field = convolution.apply(charges, size, size);
+            });
+
+            if (pixels * pixels <= _options.maxPairs) {
+                add("computeForceField/direct", size, 0, pixels * pixels, "pairs", [&] {
+                    _backend.computeForceField(_values, size, size);
+                    sync();
+                });
+            } else {
+                skip("computeForceField/direct", size, 0);
+            }
+
+            _backend.setForceField(_field, size, size);
+
+            auto darkness = std::vector<f32>(_values.size());
+            std::ranges::transform(_values, darkness.begin(), [](auto x) { return 1.f - x; });
+            _density.build(darkness);
+            _backend.setDensity(_density, size);
+        }
+
+        void runParticles(u32 size, u32 n)
+        {
+            const Step step{{size - 1.f, size - 1.f}, 1};
+            const auto pairs = f64(n) * n;
+
+            add("initializeParticles", size, n, n, "particles", [&] {
+                _backend.seedParticles(n, 0);
+                sync();
+            });
+
+            u32 iteration = 0;
+            add("shake", size, n, n, "particles", [&] {
+                _backend.shake(0, iteration++, 0.1f);
+                sync();
+            });
+
+            if (pairs <= _options.maxPairs) {
+                add("nextIteration/exact", size, n, pairs, "interactions", [&] {
+                    _backend.iterateExact(step);
+                    sync();
+                });
+                add("nextIteration/tiled", size, n, pairs, "interactions", [&] {
+                    _backend.iterateTiled(step, 128, 2);
+                    sync();
+                });
+            } else {
+                skip("nextIteration/exact", size, n);
+                skip("nextIteration/tiled", size, n);
+            }
+
+            /// the host-side structures are rebuilt every iteration, as ElectrostaticHalftoning does.
+            add("nextIteration/barnes-hut", size, n, n, "particles", [&] {
+                _backend.particles(_host);
+                _quadTree.build(_host);
+                _backend.iterateBarnesHut(step, _quadTree, 0.5f);
+                sync();
+            });
+            add("nextIteration/p3m", size, n, n, "particles", [&] {
+                _backend.particles(_host);
+                _particleMesh.build(_host, size, size);
+                _backend.iterateParticleMesh(step, _particleMesh);
+                sync();
+            });
+
+            add("updateResult", size, n, n, "particles", [&] {
+                _backend.beginReadback();
+                _backend.finishReadback(_host);
+            });
+
+            auto points = std::make_shared<PointFrame::Points>(_host);
+            const PointFrame frame(std::move(points));
+
+            add("render", size, n, n, "particles", [&] {
+                _renderer.setFrame(frame);
+                _renderer.image(QSize(size, size));
+            });
+
+            const auto path = _scratch + "/bench.svg";
+            add("exportSvg", size, n, n, "particles", [&] {
+                writeSvg(path, frame, QSize(size, size));
+            });
+        }
+
+        const Options& _options;
+        Backend& _backend;
+        QString _scratch;
+        std::vector<Record> _records;
+
+        std::vector<f32> _values;
+        std::vector<f32> _field;
+        std::vector<compute::float2_> _host;
+        AliasTable _density;
+        QuadTree _quadTree;
+        ParticleMesh _particleMesh;
+        gui::SplatRenderer _renderer;
+    };
+
+    QByteArray toJson(const std::vector<Record>& records, const QJsonObject& context)
+    {
+        QJsonArray results;
+        for (const auto& record : records) {
+            results.append(QJsonObject{
+                {"stage", record.stage},
+                {"size", qint64(record.size)},
+                {"particles", qint64(record.particles)},
+                {"runs", qint64(record.runs)},
+                {"seconds", record.seconds},
+                {"work", record.work},
+                {"unit", record.unit},
+                {"throughput", record.throughput()},
+            });
+        }
+
+        auto document = context;
+        document["results"] = results;
+        return QJsonDocument(document).toJson();
+    }
+
+    QByteArray toCsv(const std::vector<Record>& records)
+    {
+        QByteArray csv;
+        QTextStream stream(&csv);
+        stream << "stage,size,particles,runs,seconds,work,unit,throughput\n";
+        for (const auto& record : records) {
+            stream << record.stage << ',' << record.size << ',' << record.particles << ',' << record.runs << ','
+                   << QString::number(record.seconds, 'g', 9) << ',' << QString::number(record.work, 'g', 17) << ','
+                   << record.unit << ',' << QString::number(record.throughput(), 'g', 9) << '\n';
+        }
+        stream.flush();
+        return csv;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ElectrostaticHalftoningBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Times every stage of electrostatic halftoning over image sizes and particle "
+                                     "counts.");
+    parser.addHelpOption();
+
+    const QCommandLineOption sizesOption("sizes", "sides of the square test images, comma separated.", "list",
+                                         "128,256,512,1024");
+    const QCommandLineOption particlesOption("particles", "particle counts, comma separated (default: 2^8 to 2^21).",
+                                             "list", "256,1024,4096,16384,65536,262144,1048576,2097152");
+    const QCommandLineOption minTimeOption("min-time", "seconds each case is repeated for (default: 0.25).",
+                                           "seconds", "0.25");
+    const QCommandLineOption maxRunsOption("max-runs", "most runs of one case (default: 20).", "count", "20");
+    const QCommandLineOption maxPairsOption("max-pairs", "skip the O(N^2) stages above this many interactions "
+                                            "(default: 2^34).", "count", QString::number(1ull << 34));
+    const QCommandLineOption backendOption("backend", "auto, opencl, native or all.", "backend", "auto");
+    const QCommandLineOption precisionOption("precision", "float, mixed or double sums of the repulsion.",
+                                             "precision", "float");
+    const QCommandLineOption formatOption({"f", "format"}, "json or csv.", "format", "json");
+    const QCommandLineOption outputOption({"o", "output"}, "file to write the results to (default: stdout).",
+                                          "file");
+
+    parser.addOptions({sizesOption, particlesOption, minTimeOption, maxRunsOption, maxPairsOption, backendOption,
+                       precisionOption, formatOption, outputOption});
+    parser.process(app);
+
+    auto fail = [](const std::string& message) {
+        std::println(stderr, "{}", message);
+        return 2;
+    };
+
+    Options options;
+    options.sizes     = parseList(parser.value(sizesOption));
+    options.particles = parseList(parser.value(particlesOption));
+    options.minTime   = parser.value(minTimeOption).toDouble();
+    options.maxRuns   = std::max(1u, parser.value(maxRunsOption).toUInt());
+    options.maxPairs  = parser.value(maxPairsOption).toDouble();
+
+    if (options.sizes.empty() || options.particles.empty()) {
+        return fail("sizes and particles must list positive numbers");
+    }
+
+    const auto format = parser.value(formatOption).toLower();
+    if (format != "json" && format != "csv") {
+        return fail("unknown format " + format.toStdString());
+    }
+
+    auto type = BackendType::Auto;
+    if (const auto backend = parser.value(backendOption).toLower(); backend == "opencl") {
+        type = BackendType::OpenCL;
+    } else if (backend == "native") {
+        type = BackendType::Native;
+    } else if (backend == "all") {
+        type = BackendType::AllDevices;
+    } else if (backend != "auto") {
+        return fail("unknown backend " + backend.toStdString());
+    }
+
+    auto precision = Precision::Float;
+    if (const auto name = parser.value(precisionOption).toLower(); name == "mixed") {
+        precision = Precision::Mixed;
+    } else if (name == "double") {
+        precision = Precision::Double;
+    } else if (name != "float") {
+        return fail("unknown precision " + name.toStdString());
+    }
+
+    std::unique_ptr<Backend> backend;
+    try {
+        backend = createBackend(selectDevices(type));
+    } catch (const std::exception& e) {
+        return fail(std::string("OpenCL: ") + e.what());
+    }
+    precision = backend->setPrecision(Stage::Repulsion, precision);
+
+    QTemporaryDir scratch;
+    if (!scratch.isValid()) {
+        return fail("cannot create a temporary directory");
+    }
+
+    Suite suite(options, *backend, scratch.path());
+    suite.run();
+
+    QByteArray output;
+    if (format == "json") {
+        output = toJson(suite.records(), {
+            {"backend", QString::fromStdString(backend->name())},
+            {"precision", QString::fromStdString(std::string(toString(precision)))},
+            {"cpu", QSysInfo::currentCpuArchitecture()},
+            {"os", QSysInfo::prettyProductName()},
+            {"date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        });
+    } else {
+        output = toCsv(suite.records());
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(output) != output.size()) {
+            return fail("cannot write " + parser.value(outputOption).toStdString());
+        }
+    } else {
+        std::print("{}", output.toStdString());
+    }
+
+    return 0;
+}
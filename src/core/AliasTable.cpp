@@ -0,0 +1,55 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "AliasTable.hpp"
+
+#include <QtGlobal>
+
+#include <numeric>
+
+
+using namespace core;
+
+void AliasTable::build(std::span<const f32> weights)
+{
+    const auto n = u32(weights.size());
+
+    _probabilities.assign(n, 1.f);
+    _aliases.resize(n);
+    std::iota(_aliases.begin(), _aliases.end(), 0u);
+
+    const auto total = std::accumulate(weights.begin(), weights.end(), f64(0));
+    if (n == 0 || !(total > 0)) {
+        return;
+    }
+
+    /// weights scaled so that their mean is 1, split into the bins below and above it.
+    std::vector<f64> scaled(n);
+    std::vector<u32> small;
+    std::vector<u32> large;
+    for (u32 i = 0; i < n; ++i) {
+        Q_ASSERT(weights[i] >= 0);
+        scaled[i] = weights[i] * (n / total);
+        (scaled[i] < 1 ? small : large).push_back(i);
+    }
+
+    /// every small bin is topped up to 1 by a large one, which then may become small itself.
+    while (!small.empty() && !large.empty()) {
+        const auto s = small.back(); small.pop_back();
+        const auto l = large.back();
+
+        _probabilities[s] = f32(scaled[s]);
+        _aliases[s]       = l;
+
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    /// what is left is 1 up to rounding.
+    for (auto i : small) { _probabilities[i] = 1; }
+    for (auto i : large) { _probabilities[i] = 1; }
+}
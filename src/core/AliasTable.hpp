@@ -0,0 +1,36 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <span>
+#include <vector>
+
+
+namespace core
+{
+    /// Walker's alias method, built with Vose's algorithm: after O(n) preparation an index is
+    /// drawn with probability proportional to its weight from two uniform numbers in O(1).
+    ///
+    /// to draw, pick a bin i uniformly, then keep i if a second uniform number is below
+    /// probabilities()[i] and take aliases()[i] otherwise.
+    class AliasTable
+    {
+    public:
+        /// weights must be non-negative; if they are all zero every index is equally likely.
+        void build(std::span<const f32> weights);
+
+        std::size_t size() const { return _probabilities.size(); }
+
+        const std::vector<f32>& probabilities() const { return _probabilities; }
+
+        const std::vector<u32>& aliases() const { return _aliases; }
+
+    private:
+        std::vector<f32> _probabilities;
+        std::vector<u32> _aliases;
+    };
+}
@@ -0,0 +1,113 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+#include "AliasTable.hpp"
+#include "Precision.hpp"
+#include "ParticleMesh.hpp"
+#include "Profiler.hpp"
+#include "QuadTree.hpp"
+
+#include <boost/compute/types/fundamental.hpp>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// parameters shared by every repulsion method of one iteration.
+    struct Step
+    {
+        compute::float2_ boundry;
+        f32 radius;
+    };
+
+
+    /// how far the particles moved in one iteration.
+    struct Convergence
+    {
+        f32 maxDisplacement{0};
+        f32 meanDisplacement{0};
+        f32 energy{0}; ///< half the sum of squared displacements, a kinetic energy proxy.
+    };
+
+
+    /// owns the force field and the particles, and evaluates the stages of the
+    /// simulation on a particular kind of hardware.
+    ///
+    /// every iterate* call advances all particles by one step, after which
+    /// particles() returns the new positions.
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+
+        virtual std::string name() const = 0;
+
+        /// accumulates the sums of stage in precision from the next call on, and returns the
+        /// precision actually used, which is lower if the hardware lacks the requested one.
+        /// the force field stage only applies to computeForceField.
+        virtual Precision setPrecision(Stage stage, Precision precision) = 0;
+
+        /// computes the force field of the normalized image with the direct O(P^2) sum.
+        virtual void computeForceField(const std::vector<f32>& values, u32 width, u32 height) = 0;
+
+        /// replaces the force field with interleaved (x, y) pairs, row-major with a stride of width.
+        virtual void setForceField(std::span<const f32> field, u32 width, u32 height) = 0;
+
+        /// reads the force field back in the layout setForceField takes.
+        virtual void forceField(std::vector<f32>& field) = 0;
+
+        virtual void setParticles(const std::vector<compute::float2_>& points) = 0;
+
+        virtual void particles(std::vector<compute::float2_>& points) = 0;
+
+        /// starts copying the current positions to the host and returns without waiting;
+        /// at most two readbacks are in flight.
+        virtual void beginReadback() = 0;
+
+        /// waits for the oldest readback begun and returns its positions; false if there is none.
+        virtual bool finishReadback(std::vector<compute::float2_>& points) = 0;
+
+        /// waits until every command issued so far has completed, without copying anything.
+        virtual void finish() = 0;
+
+        /// sets the distribution seedParticles samples pixels from, row-major with a stride of width.
+        virtual void setDensity(const AliasTable& table, u32 width) = 0;
+
+        /// places count particles at random on the dark parts of the density; the same seed
+        /// gives the same particles on every backend.
+        virtual void seedParticles(u32 count, u64 seed) = 0;
+
+        /// moves every particle by magnitude times a random offset in [0, 1)^2, drawn from the
+        /// stream of (seed, iteration).
+        virtual void shake(u64 seed, u32 iteration, f32 magnitude) = 0;
+
+        /// starts measuring how far the last iterate* call moved the particles and returns
+        /// without waiting; at most two measurements are in flight.
+        virtual void beginMeasure() = 0;
+
+        /// waits for the oldest measurement begun.
+        virtual Convergence finishMeasure() = 0;
+
+        virtual void iterateExact(const Step& step) = 0;
+
+        virtual void iterateTiled(const Step& step, u32 tileSize, u32 particlesPerItem) = 0;
+
+        virtual void iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta) = 0;
+
+        virtual void iterateParticleMesh(const Step& step, const ParticleMesh& mesh) = 0;
+
+        /// records the time of every stage from now on into profiler; nullptr stops recording.
+        virtual void setProfiler(std::shared_ptr<Profiler> profiler) = 0;
+    };
+}
@@ -5,48 +5,169 @@
 #include "Controller.hpp"
 
 #include <QImage>
+#include <QTimer>
+
+#include <print>
+#include <utility>
 
 
 using namespace core;
 
 Controller::Controller(QObject* parent)
     : QObject(parent)
+{
+    /// queued, so it runs first on the thread the controller is moved to.
+    QMetaObject::invokeMethod(this, &Controller::initialize, Qt::QueuedConnection);
+}
+
+Controller::~Controller()
+{
+    /// the backends hand over the events still in their queues when they go.
+    delete std::exchange(_eh, nullptr);
+
+    if (_profiler && !_tracePath.isEmpty() && !_profiler->writeTrace(_tracePath)) {
+        std::println("cannot write {}", _tracePath.toStdString());
+    }
+}
+
+void Controller::initialize()
 {
     _eh = new ElectrostaticHalftoning(this);
+    _eh->setReadbackInterval(_readbackInterval);
+    _eh->setTolerance(_tolerance);
 
     connect(_eh, &ElectrostaticHalftoning::iterationFinished, this, &Controller::generated);
     connect(_eh, &ElectrostaticHalftoning::forceFieldGenerated, this, &Controller::forceFieldGenerated);
+
+    connect(_eh, &ElectrostaticHalftoning::iterationFinished, this, [this] {
+        if (std::exchange(_awaitingFirstFrame, false)) {
+            emit firstFrame(_sinceRequest.elapsed());
+        }
+    });
+
+    if (const auto profile = qEnvironmentVariable("EH_PROFILE"); !profile.isEmpty()) {
+        _profiler = std::make_shared<Profiler>();
+        _eh->setProfiler(_profiler);
+        if (profile.endsWith(".json", Qt::CaseInsensitive)) {
+            _tracePath = profile;
+        }
+
+        auto* timer = new QTimer(this);
+        connect(timer, &QTimer::timeout, this, [this] {
+            emit profiled(_profiler->stages());
+            _profiler->resetStages();
+        });
+        timer->start(500);
+    }
 }
 
 void Controller::consume(const QImage& image)
 {
-    emit forceFieldStarted();
-    _eh->setValues(core::normalizedValues(image), image.width(), image.height());
-    iterate();
+    request().image = image;
 }
 
 void Controller::setParticleCount(int count)
 {
-    _eh->setParticleCount(count);
-    iterate();
+    request().particleCount = count;
 }
 
 void Controller::setParticleRadius(f32 radius)
 {
-    _eh->setParticleRadius(radius);
-    iterate();
+    request().particleRadius = radius;
 }
 
 void Controller::setIterationCount(int i)
 {
-    _eh->setMaxIteration(i);
-    iterate();
+    request().iterationCount = i;
 }
 
-void Controller::iterate()
+void Controller::setRepulsion(core::Repulsion method)
 {
+    request().repulsion = method;
+}
+
+void Controller::setReadbackInterval(int interval)
+{
+    _readbackInterval = interval;
+    if (_eh != nullptr) {
+        _eh->setReadbackInterval(interval);
+    }
+}
+
+void Controller::setTolerance(f32 tolerance)
+{
+    _tolerance = tolerance;
+    if (_eh != nullptr) {
+        _eh->setTolerance(tolerance);
+    }
+}
+
+void Controller::cancel()
+{
+    _request.reset();
+    _running            = false;
+    _awaitingFirstFrame = false;
+}
+
+void Controller::checkpoint(const QString& path)
+{
+    /// before the first frame there is no image or no particles yet, and nothing worth saving.
+    if (_eh == nullptr || _eh->points().isEmpty()) {
+        std::println(stderr, "no particles to write to {}", path.toStdString());
+        return;
+    }
+    if (!_eh->checkpoint(path)) {
+        std::println("cannot write {}", path.toStdString());
+    }
+}
+
+Controller::Request& Controller::request()
+{
+    if (!_request) {
+        _request.emplace();
+        _sinceRequest.start();
+    }
+    schedule();
+    return *_request;
+}
+
+void Controller::schedule()
+{
+    if (!std::exchange(_scheduled, true)) {
+        QMetaObject::invokeMethod(this, &Controller::step, Qt::QueuedConnection);
+    }
+}
+
+void Controller::step()
+{
+    _scheduled = false;
+
+    /// every request queued behind the previous step has been received by now.
+    if (_request) {
+        const auto request = *std::exchange(_request, std::nullopt);
+
+        if (request.image) {
+            emit forceFieldStarted();
+            _eh->setValues(core::normalizedValues(*request.image), request.image->width(), request.image->height());
+        }
+        if (request.particleCount)  { _eh->setParticleCount(*request.particleCount); }
+        if (request.particleRadius) { _eh->setParticleRadius(*request.particleRadius); }
+        if (request.iterationCount) { _eh->setMaxIteration(*request.iterationCount); }
+        if (request.repulsion)      { _eh->setRepulsion(*request.repulsion); }
+
+        _running            = true;
+        _awaitingFirstFrame = true;
+    }
+
+    if (!_running) {
+        return;
+    }
+
     _eh->nextIteration();
-    if (_eh->currentIteration() < _eh->maxIterations()) {
-        iterate();
+
+    if (_eh->finished()) {
+        _running = false;
+    } else {
+        schedule();
     }
-}
\ No newline at end of file
+}
@@ -6,36 +6,94 @@
 
 #include "eh.hpp"
 
-#include <QApplication>
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QImage>
 #include <QThread>
 
+#include <optional>
+
 
 namespace core
 {
+    /// runs the simulation on its own thread as a job of one queued step per iteration.
+    ///
+    /// parameter changes arriving while a job runs are collected into one request, the latest
+    /// value of each winning, which replaces the job before its next iteration; a burst of
+    /// slider moves therefore restarts the work once, within one iteration.
     class Controller final : public QObject
     {
         Q_OBJECT
 
     signals:
-        void generated(const QVector<QPointF>& points, int iter, int iterMax);
+        void generated(const core::PointFrame& frame, int iter, int iterMax);
         void forceFieldStarted();
         void forceFieldGenerated();
 
+        /// time from the first request of a burst to the first frame of the job it started.
+        void firstFrame(qint64 ms);
+
+        /// what each stage took in the last half second; only with EH_PROFILE set.
+        void profiled(const std::vector<core::Profiler::Stage>& stages);
+
     public:
+        /// EH_PROFILE=1 profiles the runs; a path ending in .json also writes their Chrome
+        /// trace there on exit.
         explicit Controller(QObject* parent = nullptr);
 
+        ~Controller() override;
+
     public slots:
         void consume(const QImage& image);
         void setParticleCount(int count);
         void setParticleRadius(f32 radius);
         void setIterationCount(int count);
-        void iterate();
+        void setRepulsion(core::Repulsion method);
+        void setReadbackInterval(int interval);
+        void setTolerance(f32 tolerance);
+
+        /// drops pending requests and stops the job after the iteration in progress.
+        void cancel();
+
+        /// writes the particles of the current job as a point set, between two iterations; does
+        /// nothing before its first frame.
+        void checkpoint(const QString& path);
 
     private:
+        /// creates the simulation and its backend, whose program may take seconds to build,
+        /// on the controller's thread instead of the one that created the controller.
+        void initialize();
+
+        /// parameters changed since the current job started.
+        struct Request
+        {
+            std::optional<QImage> image;
+            std::optional<int> particleCount;
+            std::optional<f32> particleRadius;
+            std::optional<int> iterationCount;
+            std::optional<Repulsion> repulsion;
+        };
+
+        /// marks the request as changed and makes sure a step will pick it up.
+        Request& request();
+
+        /// queues step() unless it already is.
+        void schedule();
+
+        /// starts a new job if there is a request, then runs one iteration of the current job.
+        void step();
+
         core::ElectrostaticHalftoning* _eh{nullptr};
-        QTimer* _timer{nullptr};
+        i32 _readbackInterval{1}; ///< applied to _eh once it exists.
+        f32 _tolerance{0};        ///< applied to _eh once it exists.
+        std::optional<Request> _request;
+        bool _scheduled{false};
+        bool _running{false};
+        bool _awaitingFirstFrame{false};
+        QElapsedTimer _sinceRequest;
+        std::shared_ptr<Profiler> _profiler;
+        QString _tracePath;
     };
 
 
@@ -48,7 +106,7 @@ namespace core
             controller   = new Controller;
             controller->moveToThread(thread);
 
-            QObject::connect(qApp, &QApplication::aboutToQuit, thread, &QThread::quit);
+            QObject::connect(qApp, &QCoreApplication::aboutToQuit, thread, &QThread::quit);
             QObject::connect(thread, &QThread::finished, controller, &QObject::deleteLater);
             QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
 
@@ -57,4 +115,4 @@ namespace core
 
         return controller;
     }
-}
\ No newline at end of file
+}
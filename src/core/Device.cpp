@@ -0,0 +1,93 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "Device.hpp"
+
+#include <boost/compute/utility/source.hpp>
+
+#include <QtGlobal>
+
+#include <exception>
+#include <print>
+#include <string>
+
+
+using namespace core;
+
+namespace
+{
+    const char cl_source[] =
+    #include "kernels.cl"
+
+    /// defines of the accumulator in kernels.cl.
+    const char* buildOptions(Precision precision)
+    {
+        switch (precision) {
+            case Precision::Float:
+                return "-DEH_ACCUMULATOR=float2 -DEH_CONVERT=convert_float2 -DEH_COMPENSATED=0";
+            case Precision::Mixed:
+                return "-DEH_ACCUMULATOR=float2 -DEH_CONVERT=convert_float2 -DEH_COMPENSATED=1";
+            case Precision::Double:
+                return "-DEH_ACCUMULATOR=double2 -DEH_CONVERT=convert_double2 -DEH_COMPENSATED=0";
+        }
+        return "";
+    }
+}
+
+Device::Device(const compute::device& device)
+    : _device(device)
+    , _context(device)
+    , _workGroups(device)
+    , _autotune(qEnvironmentVariable("EH_AUTOTUNE") == "1")
+{
+    std::println("\ndevice: {}", device.name());
+    std::println("driver: {}", device.driver_version());
+    std::println("platform: {}", device.platform().name());
+    std::println("{}", device.platform().version());
+    std::println("compute units: {}", device.compute_units());
+
+    /// a failed build is left for program() to report; it builds again.
+    _prebuild = std::async(std::launch::async, [this] {
+        try {
+            program(Precision::Float);
+        } catch (const std::exception&) {
+        }
+    });
+}
+
+Device::~Device()
+{
+    if (_prebuild.valid()) {
+        _prebuild.wait();
+    }
+}
+
+bool Device::supportsDouble() const
+{
+    return _device.supports_extension("cl_khr_fp64");
+}
+
+const compute::program& Device::program(Precision precision) const
+{
+    std::lock_guard lock(_mutex);
+
+    auto& program = _programs[std::size_t(precision)];
+    if (program) {
+        return *program;
+    }
+
+    const std::string options = buildOptions(precision);
+    const auto key = ProgramCache::key(_device, cl_source, options);
+
+    program = _programCache.load(key, _context, options);
+    if (!program) {
+        auto built = compute::program::create_with_source(cl_source, _context);
+        built.build(options);
+        if (!_programCache.store(key, built)) {
+            std::println(stderr, "cannot write to the program cache in {}", _programCache.directory().toStdString());
+        }
+        program = std::move(built);
+    }
+    return *program;
+}
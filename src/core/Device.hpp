@@ -0,0 +1,77 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "Precision.hpp"
+#include "ProgramCache.hpp"
+#include "WorkGroupProfile.hpp"
+
+#include <boost/compute/context.hpp>
+#include <boost/compute/device.hpp>
+#include <boost/compute/program.hpp>
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <optional>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// an OpenCL device together with its context and the programs built from kernels.cl.
+    ///
+    /// any number of OpenClBackends, on any threads, can share one Device; each of them
+    /// creates its own command queue, buffers and kernels.
+    ///
+    /// built programs are kept in a ProgramCache in the user's cache location. the float
+    /// program, which every backend needs, starts building on a thread of its own as soon as
+    /// the Device exists, so that the build overlaps whatever runs before the first backend.
+    class Device
+    {
+    public:
+        explicit Device(const compute::device& device);
+
+        ~Device();
+
+        Device(const Device&) = delete;
+        Device& operator=(const Device&) = delete;
+
+        const compute::device& device() const { return _device; }
+
+        const compute::context& context() const { return _context; }
+
+        /// whether the device has double precision arithmetic (cl_khr_fp64).
+        bool supportsDouble() const;
+
+        /// kernels.cl built for precision, on first use. stages whose sums do not depend on
+        /// the precision may take their kernels from any of them.
+        const compute::program& program(Precision precision = Precision::Float) const;
+
+        /// the work-group sizes tuned for this device so far; every backend on it applies them.
+        WorkGroupProfile& workGroups() const { return _workGroups; }
+
+        /// whether backends time candidate work-group sizes for the kernels and problem sizes
+        /// the profile has no setting for yet, and store the fastest. each kernel runs a few
+        /// extra times whenever that happens. off unless EH_AUTOTUNE=1.
+        bool autotune() const { return _autotune; }
+
+        void setAutotune(bool autotune) { _autotune = autotune; }
+
+    private:
+        compute::device _device;
+        compute::context _context;
+
+        mutable std::mutex _mutex;
+        mutable std::array<std::optional<compute::program>, 3> _programs;
+        const ProgramCache _programCache;
+        mutable WorkGroupProfile _workGroups;
+        std::atomic<bool> _autotune{false};
+        std::future<void> _prebuild;
+    };
+}
@@ -0,0 +1,194 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "Export.hpp"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+
+using namespace core;
+
+namespace
+{
+    /// collects output in a fixed-size buffer and writes it to file whenever it fills up,
+    /// deflating it into a gzip stream first if compressed.
+    class Sink
+    {
+    public:
+        Sink(QFile& file, bool compressed)
+            : _file(file)
+            , _compressed(compressed)
+            , _buffer(chunk)
+        {
+            if (_compressed) {
+                _deflated.resize(chunk);
+                /// 15 window bits, plus 16 for a gzip rather than a zlib wrapper. the default level
+                /// compresses the repetitive markup nearly as well as level 9 at several times the speed.
+                _ok = deflateInit2(&_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) == Z_OK;
+            }
+        }
+
+        ~Sink()
+        {
+            if (_compressed) {
+                deflateEnd(&_stream);
+            }
+        }
+
+        Sink& operator<<(std::string_view text)
+        {
+            while (!text.empty()) {
+                const auto n = std::min(text.size(), _buffer.size() - _size);
+                std::memcpy(_buffer.data() + _size, text.data(), n);
+                _size += n;
+                text.remove_prefix(n);
+                if (_size == _buffer.size()) {
+                    flush(false);
+                }
+            }
+            return *this;
+        }
+
+        Sink& operator<<(char c)
+        {
+            return *this << std::string_view(&c, 1);
+        }
+
+        /// fixed notation with at most three decimals and no trailing zeros.
+        Sink& operator<<(f32 value)
+        {
+            char text[32];
+            auto* end = std::to_chars(std::begin(text), std::end(text), value, std::chars_format::fixed, 3).ptr;
+            while (end[-1] == '0') { --end; }
+            if (end[-1] == '.') { --end; }
+            if (end - text == 2 && text[0] == '-' && text[1] == '0') {
+                return *this << '0';
+            }
+            return *this << std::string_view(text, end);
+        }
+
+        /// writes what is left; false if any write failed.
+        bool finish()
+        {
+            flush(true);
+            return _ok && _file.error() == QFileDevice::NoError;
+        }
+
+    private:
+        static constexpr std::size_t chunk = 1 << 16;
+
+        void flush(bool last)
+        {
+            if (!_ok) {
+                _size = 0;
+                return;
+            }
+
+            if (!_compressed) {
+                _ok   = _file.write(_buffer.data(), qint64(_size)) == qint64(_size);
+                _size = 0;
+                return;
+            }
+
+            _stream.next_in  = reinterpret_cast<Bytef*>(_buffer.data());
+            _stream.avail_in = uInt(_size);
+            int status;
+            do {
+                _stream.next_out  = reinterpret_cast<Bytef*>(_deflated.data());
+                _stream.avail_out = uInt(_deflated.size());
+                status = deflate(&_stream, last ? Z_FINISH : Z_NO_FLUSH);
+
+                const auto n = qint64(_deflated.size() - _stream.avail_out);
+                _ok = _ok && status != Z_STREAM_ERROR && _file.write(_deflated.data(), n) == n;
+            } while (_ok && (_stream.avail_out == 0 || (last && status != Z_STREAM_END)));
+            _size = 0;
+        }
+
+        QFile& _file;
+        bool _compressed;
+        bool _ok{true};
+        std::vector<char> _buffer;
+        std::size_t _size{0};
+        std::vector<char> _deflated;
+        z_stream _stream{};
+    };
+}
+
+bool core::writeSvg(const QString& path, const PointFrame& points, const QSize& size,
+                    qreal scale, qreal dotRadius, SvgStyle style)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    const auto width  = f32(size.width() * scale + dotRadius*2.0);
+    const auto height = f32(size.height() * scale + dotRadius*2.0);
+    const auto radius = f32(dotRadius);
+
+    Sink out(file, path.endsWith(".svgz", Qt::CaseInsensitive));
+
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+        << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\""
+        << " width=\"" << width << "\" height=\"" << height << "\""
+        << " viewBox=\"" << -radius << ' ' << -radius << ' ' << width << ' ' << height << "\">\n";
+
+    switch (style) {
+        case SvgStyle::Circles:
+            out << "<g fill=\"#000000\" stroke=\"none\">\n";
+            for (const auto& p : points) {
+                out << "<circle cx=\"" << f32(p.x * scale) << "\" cy=\"" << f32(p.y * scale)
+                    << "\" r=\"" << radius << "\"/>\n";
+            }
+            out << "</g>\n";
+            break;
+
+        case SvgStyle::Path: {
+            /// a zero-length segment with round caps is a disc of the stroke width.
+            out << "<path fill=\"none\" stroke=\"#000000\" stroke-linecap=\"round\" stroke-width=\""
+                << 2 * radius << "\" d=\"";
+            std::size_t i = 0;
+            for (const auto& p : points) {
+                out << 'M' << f32(p.x * scale) << ' ' << f32(p.y * scale) << "h0";
+                if (++i % 16 == 0) {
+                    out << '\n';
+                }
+            }
+            out << "\"/>\n";
+            break;
+        }
+    }
+
+    out << "</svg>\n";
+
+    return out.finish();
+}
+
+bool core::writePoints(const QString& path, const PointFrame& points)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(4);
+
+    for (const auto& p : points) {
+        out << p.x << ' ' << p.y << '\n';
+    }
+    out.flush();
+
+    return out.status() == QTextStream::Ok && file.error() == QFileDevice::NoError;
+}
@@ -0,0 +1,31 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "PointFrame.hpp"
+
+#include <QSize>
+#include <QString>
+
+
+namespace core
+{
+    /// how writeSvg draws the dots.
+    enum class SvgStyle
+    {
+        Circles, ///< one <circle> per point; the most widely supported.
+        Path,    ///< one <path> of round-capped zero-length strokes, about half the size.
+    };
+
+    /// writes points as black dots of dotRadius on an image of size scaled by scale, with the
+    /// same layout as the viewer. a path ending in .svgz is gzip-compressed while written.
+    /// streams the points through fixed-size buffers, so memory use does not grow with their
+    /// number. returns false if the file cannot be written.
+    bool writeSvg(const QString& path, const PointFrame& points, const QSize& size,
+                  qreal scale = 1, qreal dotRadius = 1, SvgStyle style = SvgStyle::Circles);
+
+    /// writes one "x y" line per point. returns false if the file cannot be written.
+    bool writePoints(const QString& path, const PointFrame& points);
+}
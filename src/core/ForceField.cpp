@@ -0,0 +1,186 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "ForceField.hpp"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+
+using namespace core;
+
+namespace
+{
+    using Complex = std::complex<f64>;
+
+    /// in-place iterative radix-2 FFT; n must be a power of two.
+    void fft(Complex* data, u32 n, const std::vector<Complex>& twiddles)
+    {
+        for (u32 i = 1, j = 0; i < n; ++i) {
+            u32 bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+
+        for (u32 len = 2; len <= n; len <<= 1) {
+            const u32 half   = len / 2;
+            const u32 stride = n / len;
+            for (u32 i = 0; i < n; i += len) {
+                for (u32 k = 0; k < half; ++k) {
+                    const auto u = data[i + k];
+                    const auto v = data[i + k + half] * twiddles[k * stride];
+                    data[i + k]        = u + v;
+                    data[i + k + half] = u - v;
+                }
+            }
+        }
+    }
+
+    std::vector<Complex> twiddles(u32 n, bool inverse)
+    {
+        const auto sign = inverse ? 1.0 : -1.0;
+        auto result = std::vector<Complex>(n / 2);
+        for (u32 k = 0; k < n / 2; ++k) {
+            result[k] = std::polar(1.0, sign * 2.0 * std::numbers::pi * k / n);
+        }
+        return result;
+    }
+
+    /// in-place 2D FFT of a row-major width x height grid; the inverse is scaled by 1/(width*height).
+    void fft2d(std::vector<Complex>& data, u32 width, u32 height, bool inverse)
+    {
+        Q_ASSERT(data.size() == std::size_t(width) * height);
+        Q_ASSERT(std::has_single_bit(width) && std::has_single_bit(height));
+
+        const auto rowTwiddles = twiddles(width, inverse);
+        for (u32 row = 0; row < height; ++row) {
+            fft(data.data() + std::size_t(row) * width, width, rowTwiddles);
+        }
+
+        const auto colTwiddles = twiddles(height, inverse);
+        auto column = std::vector<Complex>(height);
+        for (u32 col = 0; col < width; ++col) {
+            for (u32 row = 0; row < height; ++row) {
+                column[row] = data[std::size_t(row) * width + col];
+            }
+            fft(column.data(), height, colTwiddles);
+            for (u32 row = 0; row < height; ++row) {
+                data[std::size_t(row) * width + col] = column[row];
+            }
+        }
+
+        if (inverse) {
+            const auto scale = 1.0 / (f64(width) * height);
+            for (auto& x : data) { x *= scale; }
+        }
+    }
+}
+
+Green core::coulomb(f64 dx, f64 dy)
+{
+    const auto r2 = dx*dx + dy*dy;
+    if (r2 == 0) {
+        return {0, 0};
+    }
+    const auto inv = 1.0 / (r2 * std::sqrt(r2));
+    return {dx * inv, dy * inv};
+}
+
+FieldConvolution::FieldConvolution(GreenFunction green)
+    : _green(std::move(green))
+{
+}
+
+std::vector<f32> FieldConvolution::apply(const std::vector<f32>& charges, u32 width, u32 height)
+{
+    Q_ASSERT(charges.size() == std::size_t(width) * height);
+
+    const auto& transform   = prepare(width, height);
+    const auto paddedWidth  = transform.paddedWidth;
+    const auto paddedHeight = transform.paddedHeight;
+
+    auto grid = std::vector<Complex>(std::size_t(paddedWidth) * paddedHeight);
+    for (u32 row = 0; row < height; ++row) {
+        for (u32 col = 0; col < width; ++col) {
+            grid[std::size_t(row) * paddedWidth + col] = charges[std::size_t(row) * width + col];
+        }
+    }
+
+    fft2d(grid, paddedWidth, paddedHeight, false);
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+        grid[i] *= transform.greenHat[i];
+    }
+    fft2d(grid, paddedWidth, paddedHeight, true);
+
+    /// the x component of the field is the real part, the y component the imaginary part.
+    auto result = std::vector<f32>(std::size_t(width) * height * 2);
+    for (u32 row = 0; row < height; ++row) {
+        for (u32 col = 0; col < width; ++col) {
+            const auto& f = grid[std::size_t(row) * paddedWidth + col];
+            const auto i  = std::size_t(row) * width + col;
+            result[2*i    ] = f32(f.real());
+            result[2*i + 1] = f32(f.imag());
+        }
+    }
+
+    return result;
+}
+
+const FieldConvolution::Transform& FieldConvolution::prepare(u32 width, u32 height)
+{
+    const auto found = std::ranges::find_if(_transforms, [&](const Transform& transform) {
+        return transform.width == width && transform.height == height;
+    });
+    if (found != _transforms.end()) {
+        _transforms.splice(_transforms.begin(), _transforms, found);
+        return _transforms.front();
+    }
+
+    /// the least recently used one goes first, so that its memory is free before the new one is made.
+    if (_transforms.size() >= cachedTransforms) {
+        _transforms.pop_back();
+    }
+
+    Transform transform;
+    transform.width  = width;
+    transform.height = height;
+
+    /// at least 2n-1 cells so that the circular convolution never wraps around.
+    transform.paddedWidth  = std::bit_ceil(2 * width - 1);
+    transform.paddedHeight = std::bit_ceil(2 * height - 1);
+
+    /// field(p) = sum_q c(q) g(q - p) is a convolution with k(d) = g(-d).
+    /// both components are packed into one complex kernel, k = gx + i*gy,
+    /// which is valid because the charges are real.
+    const auto paddedWidth  = transform.paddedWidth;
+    const auto paddedHeight = transform.paddedHeight;
+    auto& greenHat = transform.greenHat;
+    greenHat.assign(std::size_t(paddedWidth) * paddedHeight, Complex(0, 0));
+
+    const auto w = i32(width);
+    const auto h = i32(height);
+    for (i32 dy = -(h - 1); dy < h; ++dy) {
+        for (i32 dx = -(w - 1); dx < w; ++dx) {
+            const auto g   = _green(-dx, -dy);
+            const auto row = u32(dy < 0 ? dy + i32(paddedHeight) : dy);
+            const auto col = u32(dx < 0 ? dx + i32(paddedWidth)  : dx);
+            greenHat[std::size_t(row) * paddedWidth + col] = Complex(g.x, g.y);
+        }
+    }
+
+    fft2d(greenHat, paddedWidth, paddedHeight, false);
+
+    _transforms.push_front(std::move(transform));
+    return _transforms.front();
+}
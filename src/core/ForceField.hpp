@@ -0,0 +1,66 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <complex>
+#include <functional>
+#include <list>
+#include <vector>
+
+
+namespace core
+{
+    /// the force exerted on a unit charge at the origin by a unit charge at (dx, dy).
+    struct Green
+    {
+        f64 x;
+        f64 y;
+    };
+
+    using GreenFunction = std::function<Green(f64 dx, f64 dy)>;
+
+    /// Coulomb-like 1/r^2 attraction used by the force field: d / |d|^3, zero at the origin.
+    Green coulomb(f64 dx, f64 dy);
+
+
+    /// computes field(p) = sum over q of charge(q) * green(q - p) for every cell p
+    /// of a width x height grid, using zero-padded (non-periodic) FFT convolution.
+    ///
+    /// the transformed Green's function only depends on the grid size; the ones of the
+    /// last few sizes are kept, so that alternating sizes (tiles at the edges and inside an
+    /// image, or switching images) do not transform it again.
+    class FieldConvolution
+    {
+    public:
+        explicit FieldConvolution(GreenFunction green);
+
+        /// returns interleaved (x, y) pairs, row-major with a stride of width.
+        std::vector<f32> apply(const std::vector<f32>& charges, u32 width, u32 height);
+
+    private:
+        using Complex = std::complex<f64>;
+
+        /// the transformed Green's function of one grid size.
+        struct Transform
+        {
+            u32 width{0};
+            u32 height{0};
+            u32 paddedWidth{0};
+            u32 paddedHeight{0};
+            std::vector<Complex> greenHat;
+        };
+
+        /// transforms kept; each takes 16 bytes per cell of the padded grid.
+        static constexpr std::size_t cachedTransforms = 3;
+
+        /// the transform of width x height, made the most recently used one.
+        const Transform& prepare(u32 width, u32 height);
+
+        GreenFunction _green;
+        std::list<Transform> _transforms; ///< most recently used first.
+    };
+}
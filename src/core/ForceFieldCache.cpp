@@ -0,0 +1,146 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "ForceFieldCache.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+
+using namespace core;
+
+namespace
+{
+    struct Header
+    {
+        char magic[8];
+        u32 version;
+        u32 width;
+        u32 height;
+        u32 reserved;
+    };
+
+    constexpr char magic[8] = {'E', 'H', 'F', 'I', 'E', 'L', 'D', '\0'};
+
+    static_assert(sizeof(Header) % alignof(f32) == 0);
+}
+
+ForceFieldCache::ForceFieldCache(const QString& directory, qint64 maxBytes)
+    : _directory(directory)
+    , _maxBytes(maxBytes)
+{
+    if (_directory.isEmpty()) {
+        _directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/forcefields";
+    }
+}
+
+QByteArray ForceFieldCache::key(const std::vector<f32>& values, u32 width, u32 height, u32 method)
+{
+    const u32 parameters[] = {version, width, height, method};
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(parameters), sizeof(parameters)));
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(f32)));
+
+    return hash.result().toHex();
+}
+
+std::optional<ForceFieldCache::Entry> ForceFieldCache::load(const QByteArray& key, u32 width, u32 height) const
+{
+    const auto count = std::size_t(2) * width * height;
+
+    auto file = std::make_unique<QFile>(path(key));
+    if (!file->open(QIODevice::ReadOnly) || file->size() != qint64(sizeof(Header) + count * sizeof(f32))) {
+        return std::nullopt;
+    }
+
+    const auto* data = file->map(0, file->size());
+    if (data == nullptr) {
+        return std::nullopt;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        header.width != width || header.height != height) {
+        return std::nullopt;
+    }
+
+    /// the access time is what prune goes by; it is set explicitly, since file systems mounted
+    /// with noatime or relatime do not keep it up to date.
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileAccessTime);
+
+    const auto* field = reinterpret_cast<const f32*>(data + sizeof(Header));
+    return Entry{std::move(file), std::span(field, count)};
+}
+
+bool ForceFieldCache::store(const QByteArray& key, std::span<const f32> field, u32 width, u32 height) const
+{
+    Q_ASSERT(field.size() == std::size_t(2) * width * height);
+
+    if (!QDir().mkpath(_directory)) {
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.width   = width;
+    header.height  = height;
+
+    /// written under a temporary name and renamed, so concurrent readers never see a partial entry.
+    QSaveFile file(path(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(field.data()), qint64(field.size_bytes()));
+
+    if (!file.commit()) {
+        return false;
+    }
+
+    prune(QFileInfo(path(key)).absoluteFilePath());
+    return true;
+}
+
+QString ForceFieldCache::path(const QByteArray& key) const
+{
+    return _directory + '/' + QString::fromLatin1(key) + ".field";
+}
+
+void ForceFieldCache::prune(const QString& kept) const
+{
+    if (_maxBytes <= 0) {
+        return;
+    }
+
+    auto entries = QDir(_directory).entryInfoList({"*.field"}, QDir::Files);
+    qint64 total = 0;
+    for (const auto& entry : entries) {
+        total += entry.size();
+    }
+    if (total <= _maxBytes) {
+        return;
+    }
+
+    /// an entry another process has mapped stays readable to it after removal on POSIX systems;
+    /// elsewhere the removal fails and the entry is left for a later store.
+    std::ranges::sort(entries, {}, [](const QFileInfo& entry) { return entry.lastRead(); });
+    for (const auto& entry : entries) {
+        if (total <= _maxBytes) {
+            break;
+        }
+        if (entry.absoluteFilePath() != kept && QFile::remove(entry.absoluteFilePath())) {
+            total -= entry.size();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace core
+{
+    /// force fields on disk, addressed by the content they were computed from.
+    ///
+    /// each entry is one file: a small header followed by the field as interleaved (x, y)
+    /// pairs, the layout Backend::setForceField takes, so a hit is memory-mapped and handed
+    /// to the backend without parsing or copying on the host. the directory is kept below a
+    /// size limit by removing the least recently used entries whenever one is stored.
+    class ForceFieldCache
+    {
+    public:
+        /// bump whenever the force field computation changes, so older entries are ignored.
+        static constexpr u32 version = 1;
+
+        /// a mapped entry; field stays valid as long as this object lives.
+        struct Entry
+        {
+            std::unique_ptr<QFile> file;
+            std::span<const f32> field;
+        };
+
+        /// the size limit unless another is given: a few hundred fields of a megapixel image.
+        static constexpr qint64 defaultMaxBytes = qint64(2) << 30;
+
+        /// an empty directory means the "forcefields" directory in the user's cache location.
+        /// maxBytes limits the size of the entries in it, 0 means no limit.
+        explicit ForceFieldCache(const QString& directory = {}, qint64 maxBytes = defaultMaxBytes);
+
+        const QString& directory() const { return _directory; }
+
+        qint64 maxBytes() const { return _maxBytes; }
+
+        /// the key of the field of normalized values; method tells apart fields computed
+        /// differently from the same image.
+        static QByteArray key(const std::vector<f32>& values, u32 width, u32 height, u32 method);
+
+        /// maps the entry stored under key, if there is a valid one of the given size, and marks
+        /// it as used.
+        std::optional<Entry> load(const QByteArray& key, u32 width, u32 height) const;
+
+        /// stores field under key, replacing the file atomically, then removes the least recently
+        /// used other entries while the directory exceeds maxBytes; returns false on failure.
+        bool store(const QByteArray& key, std::span<const f32> field, u32 width, u32 height) const;
+
+    private:
+        QString path(const QByteArray& key) const;
+
+        /// removes entries other than kept, least recently used first, until the rest fit maxBytes.
+        void prune(const QString& kept) const;
+
+        QString _directory;
+        qint64 _maxBytes{defaultMaxBytes};
+    };
+}
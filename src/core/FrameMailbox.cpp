@@ -0,0 +1,82 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "FrameMailbox.hpp"
+
+#include <QTimer>
+
+#include <cmath>
+#include <utility>
+
+
+using namespace core;
+
+FrameMailbox::FrameMailbox(QObject* parent)
+    : QObject(parent)
+{
+    _timer = new QTimer(this);
+    _timer->setSingleShot(true);
+    _timer->setTimerType(Qt::PreciseTimer);
+    connect(_timer, &QTimer::timeout, this, &FrameMailbox::deliver);
+}
+
+void FrameMailbox::setRefreshRate(qreal hz)
+{
+    _interval = hz > 0 ? i32(std::floor(1000 / hz)) : 0;
+}
+
+void FrameMailbox::post(const PointFrame& frame, int iter, int iterMax)
+{
+    {
+        std::lock_guard lock(_mutex);
+        if (_pending) {
+            _superseded++;
+            _dropped++;
+        }
+        _frame   = frame;
+        _iter    = iter;
+        _iterMax = iterMax;
+        _pending = true;
+
+        if (std::exchange(_scheduled, true)) {
+            return;
+        }
+    }
+
+    QMetaObject::invokeMethod(this, &FrameMailbox::schedule, Qt::QueuedConnection);
+}
+
+u64 FrameMailbox::dropped() const
+{
+    std::lock_guard lock(_mutex);
+    return _dropped;
+}
+
+void FrameMailbox::schedule()
+{
+    const auto wait = _sinceDelivery.isValid() ? _interval - _sinceDelivery.elapsed() : 0;
+    if (wait > 0) {
+        _timer->start(i32(wait));
+    } else {
+        deliver();
+    }
+}
+
+void FrameMailbox::deliver()
+{
+    PointFrame frame;
+    int iter, iterMax, dropped;
+    {
+        std::lock_guard lock(_mutex);
+        frame      = std::exchange(_frame, {});
+        iter       = _iter;
+        iterMax    = _iterMax;
+        dropped    = std::exchange(_superseded, 0);
+        _pending   = false;
+        _scheduled = false;
+    }
+
+    _sinceDelivery.start();
+    emit delivered(frame, iter, iterMax, dropped);
+}
@@ -0,0 +1,65 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+#include "PointFrame.hpp"
+
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <mutex>
+
+
+class QTimer;
+
+namespace core
+{
+    /// hands frames from the simulation thread to the thread this lives in, latest frame wins.
+    ///
+    /// post() never waits for the receiver: a frame that is still waiting when the next one
+    /// arrives is replaced and dropped, which releases its buffer without copying it. delivery
+    /// is capped at one frame per interval, so the receiver repaints at most at display rate
+    /// however fast the iterations run.
+    class FrameMailbox final : public QObject
+    {
+        Q_OBJECT
+
+    signals:
+        /// the latest frame posted; dropped counts the frames it superseded since the last delivery.
+        void delivered(const core::PointFrame& frame, int iter, int iterMax, int dropped);
+
+    public:
+        explicit FrameMailbox(QObject* parent = nullptr);
+
+        /// at most one delivery per refresh of a display at hz.
+        void setRefreshRate(qreal hz);
+
+        /// thread-safe; may be called from any thread.
+        void post(const core::PointFrame& frame, int iter, int iterMax);
+
+        /// frames dropped since construction.
+        u64 dropped() const;
+
+    private:
+        /// delivers now, or once the interval since the last delivery has passed.
+        void schedule();
+
+        void deliver();
+
+        mutable std::mutex _mutex;
+        PointFrame _frame;
+        int _iter{0};
+        int _iterMax{0};
+        bool _pending{false};   ///< a frame is waiting.
+        bool _scheduled{false}; ///< a delivery is on its way.
+        int _superseded{0};
+        u64 _dropped{0};
+
+        i32 _interval{16}; ///< ms.
+        QElapsedTimer _sinceDelivery;
+        QTimer* _timer{nullptr};
+    };
+}
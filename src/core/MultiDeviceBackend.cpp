@@ -0,0 +1,308 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "MultiDeviceBackend.hpp"
+#include "Philox.hpp"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ranges>
+
+
+using namespace core;
+
+MultiDeviceBackend::MultiDeviceBackend(const std::vector<std::shared_ptr<Device>>& devices)
+{
+    Q_ASSERT(!devices.empty());
+
+    for (const auto& device : devices) {
+        Part part;
+        /// the slices are balanced by the device time of every iteration.
+        part.backend = std::make_unique<OpenClBackend>(device, true);
+        part.name    = device->device().name();
+        /// a first guess until the devices have been timed.
+        part.rate    = f64(device->device().compute_units()) * std::max(1u, device->device().clock_frequency());
+        _parts.push_back(std::move(part));
+    }
+}
+
+std::string MultiDeviceBackend::name() const
+{
+    std::string names;
+    for (const auto& part : _parts) {
+        names += (names.empty() ? "" : " + ") + part.name;
+    }
+    return "OpenCL (" + names + ")";
+}
+
+void MultiDeviceBackend::setProfiler(std::shared_ptr<Profiler> profiler)
+{
+    for (auto& part : _parts) {
+        part.backend->setProfiler(profiler);
+    }
+
+    _profiler = std::move(profiler);
+    if (_profiler) {
+        _hostTrack = _profiler->track("host", "exchange");
+    }
+}
+
+Precision MultiDeviceBackend::setPrecision(Stage stage, Precision precision)
+{
+    auto used = precision;
+    for (auto& part : _parts) {
+        used = std::min(used, part.backend->setPrecision(stage, precision));
+    }
+    /// the devices that could run precision fall back with the others, so that every slice is
+    /// computed in the precision returned.
+    if (used != precision) {
+        for (auto& part : _parts) {
+            part.backend->setPrecision(stage, used);
+        }
+    }
+    return used;
+}
+
+void MultiDeviceBackend::computeForceField(const std::vector<f32>& values, u32 width, u32 height)
+{
+    std::vector<f32> field;
+    _parts.front().backend->computeForceField(values, width, height);
+    _parts.front().backend->forceField(field);
+
+    for (auto& part : _parts | std::views::drop(1)) {
+        part.backend->setForceField(field, width, height);
+    }
+}
+
+void MultiDeviceBackend::setForceField(std::span<const f32> field, u32 width, u32 height)
+{
+    for (auto& part : _parts) {
+        part.backend->setForceField(field, width, height);
+    }
+}
+
+void MultiDeviceBackend::forceField(std::vector<f32>& field)
+{
+    _parts.front().backend->forceField(field);
+}
+
+void MultiDeviceBackend::setParticles(const std::vector<compute::float2_>& points)
+{
+    _points = points;
+    for (auto& part : _parts) {
+        part.backend->setParticles(_points);
+    }
+    rebalance();
+}
+
+void MultiDeviceBackend::particles(std::vector<compute::float2_>& points)
+{
+    points = _points;
+}
+
+void MultiDeviceBackend::beginReadback()
+{
+    _readbacks.push_back(_points);
+}
+
+bool MultiDeviceBackend::finishReadback(std::vector<compute::float2_>& points)
+{
+    if (_readbacks.empty()) {
+        return false;
+    }
+    points = std::move(_readbacks.front());
+    _readbacks.pop_front();
+    return true;
+}
+
+void MultiDeviceBackend::finish()
+{
+    for (auto& part : _parts) {
+        part.backend->finish();
+    }
+}
+
+void MultiDeviceBackend::setDensity(const AliasTable& table, u32 width)
+{
+    _parts.front().backend->setDensity(table, width);
+}
+
+void MultiDeviceBackend::seedParticles(u32 count, u64 seed)
+{
+    /// seeded once, so that every device starts from the very same positions.
+    _parts.front().backend->seedParticles(count, seed);
+    _parts.front().backend->particles(_points);
+    setParticles(_points);
+}
+
+void MultiDeviceBackend::shake(u64 seed, u32 iteration, f32 magnitude)
+{
+    /// the positions are already on the host, so the offsets are added there, from the same
+    /// streams as the kernel, and sent to every device at once instead of read back again.
+    {
+        const Profiler::Scope scope(_profiler.get(), _hostTrack, "shake");
+
+        const auto key = philoxKey(seed);
+        for (u32 i = 0; i < _points.size(); ++i) {
+            const auto r = philox({i, iteration, 0, 0}, key);
+            _points[i].x += magnitude * uniform(r[0]);
+            _points[i].y += magnitude * uniform(r[1]);
+        }
+    }
+
+    std::vector<compute::event> writes;
+    for (auto& part : _parts) {
+        writes.push_back(part.backend->beginWriteParticles(_points, 0, u32(_points.size())));
+    }
+    for (auto& write : writes) {
+        write.wait();
+    }
+}
+
+void MultiDeviceBackend::beginMeasure()
+{
+    Convergence measured;
+    for (std::size_t i = 0; i < _points.size() && i < _previous.size(); ++i) {
+        const auto dx = _points[i].x - _previous[i].x;
+        const auto dy = _points[i].y - _previous[i].y;
+        const auto d2 = dx*dx + dy*dy;
+        measured.maxDisplacement   = std::max(measured.maxDisplacement, std::sqrt(d2));
+        measured.meanDisplacement += std::sqrt(d2);
+        measured.energy           += d2;
+    }
+    measured.meanDisplacement /= std::max<std::size_t>(1, _points.size());
+    measured.energy           /= 2;
+    _measures.push_back(measured);
+}
+
+Convergence MultiDeviceBackend::finishMeasure()
+{
+    Q_ASSERT(!_measures.empty());
+
+    const auto measured = _measures.front();
+    _measures.pop_front();
+    return measured;
+}
+
+void MultiDeviceBackend::iterateExact(const Step& step)
+{
+    advance([&](OpenClBackend& backend) { backend.iterateExact(step); });
+}
+
+void MultiDeviceBackend::iterateTiled(const Step& step, u32 tileSize, u32 particlesPerItem)
+{
+    advance([&](OpenClBackend& backend) { backend.iterateTiled(step, tileSize, particlesPerItem); });
+}
+
+void MultiDeviceBackend::iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta)
+{
+    advance([&](OpenClBackend& backend) { backend.iterateBarnesHut(step, tree, theta); });
+}
+
+void MultiDeviceBackend::iterateParticleMesh(const Step& step, const ParticleMesh& mesh)
+{
+    advance([&](OpenClBackend& backend) { backend.iterateParticleMesh(step, mesh); });
+}
+
+template <typename Iterate>
+void MultiDeviceBackend::advance(Iterate iterate)
+{
+    for (auto& part : _parts) {
+        if (part.count > 0) {
+            iterate(*part.backend);
+        }
+    }
+
+    /// the slices overwrite every position, so the old ones are kept instead of copied.
+    _previous.swap(_points);
+    _points.resize(_previous.size());
+    exchange();
+
+    /// a device's time per particle barely depends on which particles it has. the first
+    /// timing replaces the guess, which is in other units; an idle device that was never
+    /// timed is assumed to be as slow as the slowest one that was.
+    auto slowest = std::numeric_limits<f64>::max();
+    for (auto& part : _parts) {
+        const auto time = part.backend->lastIterationTime().count();
+        if (part.count > 0 && time > 0) {
+            const auto rate = f64(part.count) / f64(time);
+            part.rate  = part.timed ? (part.rate + rate) / 2 : rate;
+            part.timed = true;
+        }
+        if (part.timed) {
+            slowest = std::min(slowest, part.rate);
+        }
+    }
+    for (auto& part : _parts) {
+        if (!part.timed && slowest < std::numeric_limits<f64>::max()) {
+            part.rate  = slowest;
+            part.timed = true;
+        }
+    }
+    rebalance();
+}
+
+void MultiDeviceBackend::exchange()
+{
+    const Profiler::Scope scope(_profiler.get(), _hostTrack, "exchange");
+
+    std::vector<compute::event> reads;
+    for (auto& part : _parts) {
+        if (part.count > 0) {
+            reads.push_back(part.backend->beginReadSlice(_points));
+        }
+    }
+    for (auto& read : reads) {
+        read.wait();
+    }
+
+    /// every device gets the positions it did not compute itself, all devices at once; an idle
+    /// one gets all of them.
+    const auto n = u32(_points.size());
+    std::vector<compute::event> writes;
+    for (auto& part : _parts) {
+        if (part.count == 0) {
+            writes.push_back(part.backend->beginWriteParticles(_points, 0, n));
+            continue;
+        }
+        if (part.first > 0) {
+            writes.push_back(part.backend->beginWriteParticles(_points, 0, part.first));
+        }
+        if (const auto end = part.first + part.count; end < n) {
+            writes.push_back(part.backend->beginWriteParticles(_points, end, n - end));
+        }
+    }
+    for (auto& write : writes) {
+        write.wait();
+    }
+}
+
+void MultiDeviceBackend::rebalance()
+{
+    const auto n = u32(_points.size());
+
+    f64 total = 0;
+    for (const auto& part : _parts) {
+        total += part.rate;
+    }
+
+    /// cumulative rounding keeps the slices contiguous and covering all particles; a part
+    /// that would get none is idle for an iteration and keeps its last rate.
+    f64 reached = 0;
+    u32 first   = 0;
+    for (auto& part : _parts) {
+        reached += part.rate;
+        const auto end = &part == &_parts.back() ? n : u32(std::lround(n * reached / total));
+
+        part.first = first;
+        part.count = end - first;
+        if (part.count > 0) {
+            part.backend->setSlice(part.first, part.count);
+        }
+        first = end;
+    }
+}
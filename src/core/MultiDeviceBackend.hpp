@@ -0,0 +1,107 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "Backend.hpp"
+#include "OpenClBackend.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+
+namespace core
+{
+    /// splits the particles between an OpenClBackend per device.
+    ///
+    /// every device holds all positions and advances its own contiguous slice of them against
+    /// the whole set; after each iteration the slices are gathered on the host and the positions
+    /// of the other slices are written back to every device. the slices follow the throughput
+    /// each device reached in the previous iteration, timed on its queue, so devices of
+    /// different speeds finish together.
+    ///
+    /// the exchange makes every iteration wait for the devices, and the direct force field is
+    /// computed on the first device only.
+    class MultiDeviceBackend final : public Backend
+    {
+    public:
+        explicit MultiDeviceBackend(const std::vector<std::shared_ptr<Device>>& devices);
+
+        std::string name() const override;
+
+        /// profiles every device, and the exchange on the host.
+        void setProfiler(std::shared_ptr<Profiler> profiler) override;
+
+        /// the lowest precision any of the devices runs stage in, which all of them then use.
+        Precision setPrecision(Stage stage, Precision precision) override;
+
+        void computeForceField(const std::vector<f32>& values, u32 width, u32 height) override;
+
+        void setForceField(std::span<const f32> field, u32 width, u32 height) override;
+
+        void forceField(std::vector<f32>& field) override;
+
+        void setParticles(const std::vector<compute::float2_>& points) override;
+
+        /// the positions are on the host after every iteration; none of these wait.
+        void particles(std::vector<compute::float2_>& points) override;
+
+        void beginReadback() override;
+
+        bool finishReadback(std::vector<compute::float2_>& points) override;
+
+        void finish() override;
+
+        void setDensity(const AliasTable& table, u32 width) override;
+
+        void seedParticles(u32 count, u64 seed) override;
+
+        /// applied to the positions on the host and written to every device.
+        void shake(u64 seed, u32 iteration, f32 magnitude) override;
+
+        /// measured on the host from the gathered positions.
+        void beginMeasure() override;
+
+        Convergence finishMeasure() override;
+
+        void iterateExact(const Step& step) override;
+
+        void iterateTiled(const Step& step, u32 tileSize, u32 particlesPerItem) override;
+
+        void iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta) override;
+
+        void iterateParticleMesh(const Step& step, const ParticleMesh& mesh) override;
+
+    private:
+        struct Part
+        {
+            std::unique_ptr<OpenClBackend> backend;
+            std::string name;
+            f64 rate{1};   ///< particles advanced per nanosecond, smoothed over the iterations.
+            bool timed{false};
+            u32 first{0};
+            u32 count{0};  ///< 0 leaves the device idle.
+        };
+
+        /// runs iterate on the parts with a slice, then gathers the result.
+        template <typename Iterate>
+        void advance(Iterate iterate);
+
+        /// reads every slice into _points and writes the rest back to each device; the reads and
+        /// then the writes are issued on every device before waiting for any of them.
+        void exchange();
+
+        /// cuts the particles into slices proportional to the rates of the parts.
+        void rebalance();
+
+        std::vector<Part> _parts;
+        std::vector<compute::float2_> _points;
+        std::vector<compute::float2_> _previous; ///< input of the last iteration.
+        std::deque<std::vector<compute::float2_>> _readbacks;
+        std::deque<Convergence> _measures;
+        std::shared_ptr<Profiler> _profiler;
+        u32 _hostTrack{0};
+    };
+}
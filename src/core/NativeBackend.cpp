@@ -0,0 +1,567 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "NativeBackend.hpp"
+#include "Philox.hpp"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+
+using namespace core;
+
+#if defined(__x86_64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+    #define EH_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+    #define EH_TARGET_CLONES
+#endif
+
+namespace
+{
+    using float2 = compute::float2_;
+
+    /// lanes of the partial sums kept by the inner loops; a multiple of every vector width.
+    constexpr u32 lanes = 16;
+
+    constexpr f32 tau = 0.1f;
+
+    /// bilinear interpolation, same as bilinear() in kernels.cl.
+    float2 bilinear(const std::vector<float2>& field, float2 pos, u32 width)
+    {
+        const auto x1 = std::floor(pos.x);
+        const auto y1 = std::floor(pos.y);
+        const auto x2 = std::floor(pos.x + 1);
+        const auto y2 = std::floor(pos.y + 1);
+
+        const auto w11 = (x2 - pos.x) * (y2 - pos.y);
+        const auto w12 = (x2 - pos.x) * (pos.y - y1);
+        const auto w21 = (pos.x - x1) * (y2 - pos.y);
+        const auto w22 = (pos.x - x1) * (pos.y - y1);
+
+        const auto i1 = u32(y1) * width + u32(x1);
+        const auto i2 = i1 + width;
+
+        return { w11 * field[i1].x + w21 * field[i1+1].x + w12 * field[i2].x + w22 * field[i2+1].x
+               , w11 * field[i1].y + w21 * field[i1+1].y + w12 * field[i2].y + w22 * field[i2+1].y };
+    }
+
+    /// 1/|e|^3, or zero for coincident particles; written as selects so that it vectorises.
+    inline f32 inverseCube(f32 d2)
+    {
+        const auto safe = d2 > 0 ? d2 : 1.f;
+        const auto inv  = 1.f / (safe * std::sqrt(safe));
+        return d2 > 0 ? inv : 0.f;
+    }
+
+    /// adds x to sum, carrying the rounding error of the addition along in error when
+    /// compensated (Kahan summation); the host counterpart of accumulate() in kernels.cl.
+    template <bool compensated, typename T>
+    inline void accumulate(T& sum, [[maybe_unused]] T& error, T x)
+    {
+        if constexpr (compensated) {
+            const auto y = x - error;
+            const auto t = sum + y;
+            error = (t - sum) - y;
+            sum   = t;
+        } else {
+            sum += x;
+        }
+    }
+
+    /// calls f.operator()<T, compensated>() with the sum type and compensation of precision.
+    template <typename F>
+    void dispatch(Precision precision, F&& f)
+    {
+        switch (precision) {
+            case Precision::Float:  f.template operator()<f32, false>(); break;
+            case Precision::Mixed:  f.template operator()<f32, true>(); break;
+            case Precision::Double: f.template operator()<f64, false>(); break;
+        }
+    }
+
+    /// adds the push between particle i and every particle in [begin, end) to both sides.
+    template <typename T, bool compensated>
+    EH_TARGET_CLONES
+    void interact(const f32* __restrict x, const f32* __restrict y, T* __restrict pushX, T* __restrict pushY,
+                  T* __restrict errorX, T* __restrict errorY, u32 i, u32 begin, u32 end)
+    {
+        const auto xi = x[i];
+        const auto yi = y[i];
+
+        T sumX[lanes] = {};
+        T sumY[lanes] = {};
+        T errX[lanes] = {};
+        T errY[lanes] = {};
+
+        u32 j = begin;
+        for (; j + lanes <= end; j += lanes) {
+            for (u32 l = 0; l < lanes; ++l) {
+                const auto dx = x[j + l] - xi;
+                const auto dy = y[j + l] - yi;
+                const auto s  = inverseCube(dx*dx + dy*dy);
+                accumulate<compensated>(sumX[l], errX[l], T(s * dx));
+                accumulate<compensated>(sumY[l], errY[l], T(s * dy));
+                accumulate<compensated>(pushX[j + l], errorX[j + l], T(-s * dx));
+                accumulate<compensated>(pushY[j + l], errorY[j + l], T(-s * dy));
+            }
+        }
+        for (; j < end; ++j) {
+            const auto dx = x[j] - xi;
+            const auto dy = y[j] - yi;
+            const auto s  = inverseCube(dx*dx + dy*dy);
+            accumulate<compensated>(sumX[0], errX[0], T(s * dx));
+            accumulate<compensated>(sumY[0], errY[0], T(s * dy));
+            accumulate<compensated>(pushX[j], errorX[j], T(-s * dx));
+            accumulate<compensated>(pushY[j], errorY[j], T(-s * dy));
+        }
+
+        for (u32 l = 0; l < lanes; ++l) {
+            accumulate<compensated>(pushX[i], errorX[i], sumX[l] - errX[l]);
+            accumulate<compensated>(pushY[i], errorY[i], sumY[l] - errY[l]);
+        }
+    }
+
+    /// force field at (col, row) from a single row of charges.
+    template <typename T, bool compensated>
+    EH_TARGET_CLONES
+    void accumulateRow(const f32* __restrict values, u32 width, f32 col, f32 dy, T& fx, T& fy, T& errorX, T& errorY)
+    {
+        T sumX[lanes] = {};
+        T sumY[lanes] = {};
+        T errX[lanes] = {};
+        T errY[lanes] = {};
+
+        u32 c = 0;
+        for (; c + lanes <= width; c += lanes) {
+            for (u32 l = 0; l < lanes; ++l) {
+                const auto dx = f32(c + l) - col;
+                const auto s  = (1.f - values[c + l]) * inverseCube(dx*dx + dy*dy);
+                accumulate<compensated>(sumX[l], errX[l], T(s * dx));
+                accumulate<compensated>(sumY[l], errY[l], T(s * dy));
+            }
+        }
+        for (; c < width; ++c) {
+            const auto dx = f32(c) - col;
+            const auto s  = (1.f - values[c]) * inverseCube(dx*dx + dy*dy);
+            accumulate<compensated>(sumX[0], errX[0], T(s * dx));
+            accumulate<compensated>(sumY[0], errY[0], T(s * dy));
+        }
+
+        for (u32 l = 0; l < lanes; ++l) {
+            accumulate<compensated>(fx, errorX, sumX[l] - errX[l]);
+            accumulate<compensated>(fy, errorY, sumY[l] - errY[l]);
+        }
+    }
+}
+
+NativeBackend::NativeBackend(u32 threads)
+    : _pool(threads)
+{
+}
+
+std::string NativeBackend::name() const
+{
+    return "native (" + std::to_string(_pool.size()) + " threads)";
+}
+
+void NativeBackend::setProfiler(std::shared_ptr<Profiler> profiler)
+{
+    _profiler = std::move(profiler);
+    if (_profiler) {
+        _track = _profiler->track("host", name());
+    }
+}
+
+Precision NativeBackend::setPrecision(Stage stage, Precision precision)
+{
+    _precision[std::size_t(stage)] = precision;
+    return precision;
+}
+
+void NativeBackend::computeForceField(const std::vector<f32>& values, u32 width, u32 height)
+{
+    const auto profiled = scope("computeForceField");
+
+    Q_ASSERT(values.size() == width * height);
+
+    _width  = width;
+    _height = height;
+    _forceField.assign((width + 2) * (height + 2), float2(0, 0));
+
+    dispatch(_precision[std::size_t(Stage::ForceField)], [&]<typename T, bool compensated>() {
+        _pool.parallelFor(width * height, [&](std::size_t begin, std::size_t end) {
+            for (auto p = begin; p < end; ++p) {
+                const auto col = f32(p % width);
+                const auto row = f32(p / width);
+
+                T fx{0}, fy{0}, errorX{0}, errorY{0};
+                for (u32 r = 0; r < height; ++r) {
+                    accumulateRow<T, compensated>(values.data() + r * width, width, col, f32(r) - row,
+                                                  fx, fy, errorX, errorY);
+                }
+                _forceField[p] = float2(f32(fx - errorX), f32(fy - errorY));
+            }
+        });
+    });
+}
+
+void NativeBackend::setForceField(std::span<const f32> field, u32 width, u32 height)
+{
+    Q_ASSERT(field.size() == 2 * width * height);
+
+    _width  = width;
+    _height = height;
+    _forceField.assign((width + 2) * (height + 2), float2(0, 0));
+
+    for (std::size_t i = 0; i < field.size() / 2; ++i) {
+        _forceField[i] = float2(field[2*i], field[2*i + 1]);
+    }
+}
+
+void NativeBackend::forceField(std::vector<f32>& field)
+{
+    field.resize(2 * _width * _height);
+
+    for (std::size_t i = 0; i < field.size() / 2; ++i) {
+        field[2*i]     = _forceField[i].x;
+        field[2*i + 1] = _forceField[i].y;
+    }
+}
+
+void NativeBackend::setParticles(const std::vector<float2>& points)
+{
+    _particles_k0 = points;
+    _particles_k1.resize(points.size());
+}
+
+void NativeBackend::particles(std::vector<float2>& points)
+{
+    points = _particles_k0;
+}
+
+void NativeBackend::beginReadback()
+{
+    _readbacks.push_back(_particles_k0);
+}
+
+bool NativeBackend::finishReadback(std::vector<float2>& points)
+{
+    if (_readbacks.empty()) {
+        return false;
+    }
+    points = std::move(_readbacks.front());
+    _readbacks.pop_front();
+    return true;
+}
+
+void NativeBackend::finish()
+{
+}
+
+void NativeBackend::setDensity(const AliasTable& table, u32 width)
+{
+    _density      = table;
+    _densityWidth = width;
+}
+
+void NativeBackend::seedParticles(u32 count, u64 seed)
+{
+    const auto profiled = scope("seedParticles");
+
+    const auto key    = philoxKey(seed);
+    const auto pixels = u32(_density.size());
+    const auto width  = _densityWidth;
+    const auto& probabilities = _density.probabilities();
+    const auto& aliases       = _density.aliases();
+
+    _particles_k0.resize(count);
+    _particles_k1.resize(count);
+
+    /// same as seedParticles in kernels.cl.
+    _pool.parallelFor(count, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto r = philox({u32(i), 0, 1, 0}, key);
+
+            auto pixel = scale(r[0], pixels);
+            if (uniform(r[1]) >= probabilities[pixel]) {
+                pixel = aliases[pixel];
+            }
+
+            _particles_k0[i] = float2(f32(pixel % width) + uniform(r[2]), f32(pixel / width) + uniform(r[3]));
+        }
+    });
+}
+
+void NativeBackend::shake(u64 seed, u32 iteration, f32 magnitude)
+{
+    const auto profiled = scope("shake");
+
+    const auto key = philoxKey(seed);
+
+    _pool.parallelFor(_particles_k0.size(), [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto r = philox({u32(i), iteration, 0, 0}, key);
+            _particles_k0[i].x += magnitude * uniform(r[0]);
+            _particles_k0[i].y += magnitude * uniform(r[1]);
+        }
+    });
+}
+
+void NativeBackend::beginMeasure()
+{
+    const auto profiled = scope("measureDisplacement");
+
+    std::mutex mutex;
+    Convergence total;
+
+    /// the last iterate* call read _particles_k1 and wrote _particles_k0.
+    _pool.parallelFor(_particles_k0.size(), [&](std::size_t begin, std::size_t end) {
+        Convergence partial;
+        for (auto i = begin; i < end; ++i) {
+            const auto dx = _particles_k0[i].x - _particles_k1[i].x;
+            const auto dy = _particles_k0[i].y - _particles_k1[i].y;
+            const auto d2 = dx*dx + dy*dy;
+            partial.maxDisplacement   = std::max(partial.maxDisplacement, std::sqrt(d2));
+            partial.meanDisplacement += std::sqrt(d2);
+            partial.energy           += d2;
+        }
+
+        std::lock_guard lock(mutex);
+        total.maxDisplacement   = std::max(total.maxDisplacement, partial.maxDisplacement);
+        total.meanDisplacement += partial.meanDisplacement;
+        total.energy           += partial.energy;
+    });
+
+    total.meanDisplacement /= std::max<std::size_t>(1, _particles_k0.size());
+    total.energy           /= 2;
+    _measures.push_back(total);
+}
+
+Convergence NativeBackend::finishMeasure()
+{
+    Q_ASSERT(!_measures.empty());
+
+    const auto measured = _measures.front();
+    _measures.pop_front();
+    return measured;
+}
+
+void NativeBackend::iterateExact(const Step& step)
+{
+    const auto profiled = scope("iterate");
+
+    const auto n = u32(_particles_k0.size());
+
+    _x.resize(n);
+    _y.resize(n);
+    for (u32 i = 0; i < n; ++i) {
+        _x[i] = _particles_k0[i].x;
+        _y[i] = _particles_k0[i].y;
+    }
+
+    dispatch(_precision[std::size_t(Stage::Repulsion)], [&]<typename T, bool compensated>() {
+        auto& scratch = sums<T>();
+        scratch.reset(n);
+        exactPush<T, compensated>(scratch);
+
+        _pushX.resize(n);
+        _pushY.resize(n);
+        for (u32 i = 0; i < n; ++i) {
+            _pushX[i] = f32(scratch.x[i] - scratch.errorX[i]);
+            _pushY[i] = f32(scratch.y[i] - scratch.errorY[i]);
+        }
+    });
+
+    advance(step);
+}
+
+template <typename T, bool compensated>
+void NativeBackend::exactPush(Sums<T>& sums)
+{
+    const auto n = u32(_x.size());
+
+    /// every pair is evaluated once and applied to both particles. the particles are split
+    /// into an even number of blocks, and the block pairs are scheduled in round-robin
+    /// rounds in which no block appears twice, so threads never write to the same particle.
+    const u32 blocks    = 2 * _pool.size();
+    const u32 blockSize = (n + blocks - 1) / blocks;
+
+    auto range = [n, blockSize](u32 block) {
+        return std::pair{std::min(n, block * blockSize), std::min(n, (block + 1) * blockSize)};
+    };
+
+    auto* x      = _x.data();
+    auto* y      = _y.data();
+    auto* pushX  = sums.x.data();
+    auto* pushY  = sums.y.data();
+    auto* errorX = sums.errorX.data();
+    auto* errorY = sums.errorY.data();
+
+    _pool.parallelFor(blocks, [&](std::size_t first, std::size_t last) {
+        for (auto block = first; block < last; ++block) {
+            const auto [begin, end] = range(block);
+            for (auto i = begin; i < end; ++i) {
+                interact<T, compensated>(x, y, pushX, pushY, errorX, errorY, i, i + 1, end);
+            }
+        }
+    });
+
+    for (u32 round = 0; round < blocks - 1; ++round) {
+        _pool.parallelFor(blocks / 2, [&](std::size_t first, std::size_t last) {
+            for (auto k = first; k < last; ++k) {
+                const auto a = k == 0 ? blocks - 1 : (round + k) % (blocks - 1);
+                const auto b = k == 0 ? round : (round + blocks - 1 - k) % (blocks - 1);
+
+                const auto [beginA, endA] = range(a);
+                const auto [beginB, endB] = range(b);
+                for (auto i = beginA; i < endA; ++i) {
+                    interact<T, compensated>(x, y, pushX, pushY, errorX, errorY, i, beginB, endB);
+                }
+            }
+        });
+    }
+}
+
+void NativeBackend::iterateTiled(const Step& step, u32, u32)
+{
+    iterateExact(step);
+}
+
+void NativeBackend::iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta)
+{
+    const auto profiled = scope("iterateBarnesHut");
+
+    const auto n      = _particles_k0.size();
+    const auto& nodes = tree.nodes();
+    const auto& links = tree.links();
+    const auto& tp    = tree.points();
+    const auto theta2 = theta * theta;
+
+    _pushX.assign(n, 0.f);
+    _pushY.assign(n, 0.f);
+
+    dispatch(_precision[std::size_t(Stage::Repulsion)], [&]<typename T, bool compensated>() {
+        _pool.parallelFor(n, [&](std::size_t begin, std::size_t end) {
+            for (auto p = begin; p < end; ++p) {
+                const auto pn = _particles_k0[p];
+                T fx{0}, fy{0}, errorX{0}, errorY{0};
+
+                u32 i = 0;
+                while (i < nodes.size()) {
+                    const auto& node = nodes[i];
+                    const auto& link = links[i];
+
+                    if (link.x == 0) {
+                        for (u32 j = link.z; j < link.w; ++j) {
+                            const auto dx = tp[j].x - pn.x;
+                            const auto dy = tp[j].y - pn.y;
+                            const auto s  = inverseCube(dx*dx + dy*dy);
+                            accumulate<compensated>(fx, errorX, T(s * dx));
+                            accumulate<compensated>(fy, errorY, T(s * dy));
+                        }
+                        i = link.y;
+                        continue;
+                    }
+
+                    const auto dx = node.x - pn.x;
+                    const auto dy = node.y - pn.y;
+                    const auto d2 = dx*dx + dy*dy;
+
+                    if (node.w * node.w < theta2 * d2) {
+                        const auto s = node.z * inverseCube(d2);
+                        accumulate<compensated>(fx, errorX, T(s * dx));
+                        accumulate<compensated>(fy, errorY, T(s * dy));
+                        i = link.y;
+                    } else {
+                        i = link.x;
+                    }
+                }
+
+                _pushX[p] = f32(fx - errorX);
+                _pushY[p] = f32(fy - errorY);
+            }
+        });
+    });
+
+    advance(step);
+}
+
+void NativeBackend::iterateParticleMesh(const Step& step, const ParticleMesh& mesh)
+{
+    const auto profiled = scope("iterateParticleMesh");
+
+    const auto n       = _particles_k0.size();
+    const auto cutoff  = mesh.cutoff();
+    const auto columns = i32(mesh.cellColumns());
+    const auto rows    = i32(mesh.cellRows());
+    const auto& starts = mesh.cellStarts();
+    const auto& cp     = mesh.points();
+
+    auto field = std::vector<float2>(_forceField.size(), float2(0, 0));
+    for (std::size_t i = 0; i < mesh.field().size() / 2; ++i) {
+        field[i] = float2(mesh.field()[2*i], mesh.field()[2*i + 1]);
+    }
+
+    _pushX.resize(n);
+    _pushY.resize(n);
+
+    dispatch(_precision[std::size_t(Stage::Repulsion)], [&]<typename T, bool compensated>() {
+        _pool.parallelFor(n, [&](std::size_t begin, std::size_t end) {
+            for (auto p = begin; p < end; ++p) {
+                const auto pn  = _particles_k0[p];
+                const auto far = bilinear(field, pn, _width);
+                T fx{far.x}, fy{far.y}, errorX{0}, errorY{0};
+
+                const auto col = i32(pn.x / cutoff);
+                const auto row = i32(pn.y / cutoff);
+
+                for (auto r = std::max(row - 1, 0); r <= std::min(row + 1, rows - 1); ++r) {
+                    for (auto c = std::max(col - 1, 0); c <= std::min(col + 1, columns - 1); ++c) {
+                        const auto cell = u32(r * columns + c);
+                        for (auto j = starts[cell]; j < starts[cell + 1]; ++j) {
+                            const auto dx = cp[j].x - pn.x;
+                            const auto dy = cp[j].y - pn.y;
+                            const auto d  = std::sqrt(dx*dx + dy*dy);
+                            if (d > 0 && d < cutoff) {
+                                const auto x = d / cutoff;
+                                const auto s = x * x * x * (x * (6 * x - 15) + 10);
+                                const auto f = (1.f - s) / (d * d * d);
+                                accumulate<compensated>(fx, errorX, T(f * dx));
+                                accumulate<compensated>(fy, errorY, T(f * dy));
+                            }
+                        }
+                    }
+                }
+
+                _pushX[p] = f32(fx - errorX);
+                _pushY[p] = f32(fy - errorY);
+            }
+        });
+    });
+
+    advance(step);
+}
+
+void NativeBackend::advance(const Step& step)
+{
+    _pool.parallelFor(_particles_k0.size(), [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto pn   = _particles_k0[i];
+            const auto pull = bilinear(_forceField, pn, _width);
+
+            auto next = float2( pn.x + (pull.x - _pushX[i] * step.radius) * tau
+                              , pn.y + (pull.y - _pushY[i] * step.radius) * tau );
+
+            if (next.x < 0 || next.y < 0 || next.x > step.boundry.x || next.y > step.boundry.y) {
+                next = pn;
+            }
+            _particles_k1[i] = next;
+        }
+    });
+
+    _particles_k0.swap(_particles_k1);
+}
@@ -0,0 +1,131 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "Backend.hpp"
+#include "ThreadPool.hpp"
+
+#include <array>
+#include <deque>
+#include <type_traits>
+
+
+namespace core
+{
+    /// runs every stage on the host across a pool of threads.
+    ///
+    /// the inner loops work on contiguous x/y arrays without branches so that the
+    /// compiler can vectorise them; on x86-64 they are built for AVX-512, AVX2 and
+    /// the baseline instruction set and the best one is picked at load time.
+    class NativeBackend final : public Backend
+    {
+    public:
+        /// zero threads means one per hardware thread.
+        explicit NativeBackend(u32 threads = 0);
+
+        std::string name() const override;
+
+        /// times every stage as a span of host work.
+        void setProfiler(std::shared_ptr<Profiler> profiler) override;
+
+        /// every precision is available on the host.
+        Precision setPrecision(Stage stage, Precision precision) override;
+
+        void computeForceField(const std::vector<f32>& values, u32 width, u32 height) override;
+
+        void setForceField(std::span<const f32> field, u32 width, u32 height) override;
+
+        void forceField(std::vector<f32>& field) override;
+
+        void setParticles(const std::vector<compute::float2_>& points) override;
+
+        void particles(std::vector<compute::float2_>& points) override;
+
+        void beginReadback() override;
+
+        bool finishReadback(std::vector<compute::float2_>& points) override;
+
+        /// the stages run synchronously, so there is nothing to wait for.
+        void finish() override;
+
+        void setDensity(const AliasTable& table, u32 width) override;
+
+        void seedParticles(u32 count, u64 seed) override;
+
+        void shake(u64 seed, u32 iteration, f32 magnitude) override;
+
+        void beginMeasure() override;
+
+        Convergence finishMeasure() override;
+
+        void iterateExact(const Step& step) override;
+
+        /// there is no local memory to tile for on the host; same as iterateExact.
+        void iterateTiled(const Step& step, u32 tileSize, u32 particlesPerItem) override;
+
+        void iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta) override;
+
+        void iterateParticleMesh(const Step& step, const ParticleMesh& mesh) override;
+
+    private:
+        /// per-particle push sums of iterateExact and their rounding errors, in T.
+        template <typename T>
+        struct Sums
+        {
+            std::vector<T> x;
+            std::vector<T> y;
+            std::vector<T> errorX;
+            std::vector<T> errorY;
+
+            void reset(std::size_t n)
+            {
+                for (auto* v : {&x, &y, &errorX, &errorY}) { v->assign(n, T(0)); }
+            }
+        };
+
+        template <typename T>
+        Sums<T>& sums()
+        {
+            if constexpr (std::is_same_v<T, f64>) { return _sums64; } else { return _sums32; }
+        }
+
+        /// accumulates the push of every pair of particles in _x/_y into sums.
+        template <typename T, bool compensated>
+        void exactPush(Sums<T>& sums);
+
+        /// moves every particle by the force field and _pushX/_pushY, then swaps k0 and k1.
+        void advance(const Step& step);
+
+        /// times the enclosing stage, named like its kernel, if profiling.
+        Profiler::Scope scope(const char* name) const
+        {
+            return {_profiler.get(), _track, name};
+        }
+
+        ThreadPool _pool;
+        std::shared_ptr<Profiler> _profiler;
+        u32 _track{0};
+        u32 _width{1};
+        u32 _height{1};
+
+        AliasTable _density;
+        u32 _densityWidth{1};
+
+        std::vector<compute::float2_> _forceField;
+        std::vector<compute::float2_> _particles_k0;
+        std::vector<compute::float2_> _particles_k1;
+        std::deque<std::vector<compute::float2_>> _readbacks;
+        std::deque<Convergence> _measures;
+
+        std::vector<f32> _x;
+        std::vector<f32> _y;
+        std::vector<f32> _pushX;
+        std::vector<f32> _pushY;
+        Sums<f32> _sums32;
+        Sums<f64> _sums64;
+
+        std::array<Precision, 2> _precision{Precision::Double, Precision::Float}; ///< indexed by Stage.
+    };
+}
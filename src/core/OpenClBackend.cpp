@@ -0,0 +1,665 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "OpenClBackend.hpp"
+#include "Philox.hpp"
+
+#include <QtGlobal>
+
+#include <boost/compute/algorithm/copy.hpp>
+#include <boost/compute/algorithm/fill.hpp>
+#include <boost/compute/exception/opencl_error.hpp>
+#include <boost/compute/memory/local_buffer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <optional>
+#include <print>
+#include <string>
+#include <utility>
+
+
+using namespace core;
+
+namespace
+{
+    /// items rounded up to a whole number of work-groups of size local.
+    std::size_t padded(std::size_t items, std::size_t local)
+    {
+        return local == 0 ? items : (items + local - 1) / local * local;
+    }
+
+    cl_command_queue_properties queueProperties(bool profiled)
+    {
+        return profiled ? compute::command_queue::enable_profiling : 0;
+    }
+
+    /// the direct force field is only tuned up to this many pixels: every candidate runs the
+    /// whole O(P^2) sum, which takes minutes on a large image.
+    constexpr std::size_t maxTunedForceFieldPixels = 256 * 256;
+}
+
+OpenClBackend::OpenClBackend(std::shared_ptr<const Device> device, bool timed)
+    : _timed(timed)
+    , _device(std::move(device))
+    , _context(_device->context())
+    , _queue(_context, _device->device(), queueProperties(timed || _device->autotune()))
+    , _transfer(_context, _device->device(), queueProperties(timed || _device->autotune()))
+    , _forceField(1, _context)
+    , _particles_k0(1, _context)
+    , _particles_k1(1, _context)
+    , _treeNodes(1, _context)
+    , _treeLinks(1, _context)
+    , _treePoints(1, _context)
+    , _meshField(1, _context)
+    , _cellStarts(1, _context)
+    , _cellPoints(1, _context)
+    , _values_dev(1, _context)
+    , _densityProbabilities(1, _context)
+    , _densityAliases(1, _context)
+    , _measurePartials(1, _context)
+    , _measured(2, _context)
+{
+    const auto& program = _device->program();
+    _shakeKernel        = program.create_kernel("shake");
+    _seedKernel         = program.create_kernel("seedParticles");
+    _measureKernel      = program.create_kernel("measureDisplacement");
+    _reduceKernel       = program.create_kernel("reduceDisplacement");
+
+    setPrecision(Stage::ForceField, Precision::Double);
+    setPrecision(Stage::Repulsion, Precision::Float);
+
+    /// the reductions halve the work-group until one item is left.
+    const auto measureGroupSize = std::min({std::size_t(256),
+        _measureKernel.get_work_group_info<std::size_t>(_queue.get_device(), CL_KERNEL_WORK_GROUP_SIZE),
+        _reduceKernel.get_work_group_info<std::size_t>(_queue.get_device(), CL_KERNEL_WORK_GROUP_SIZE)});
+    _measureGroupSize = std::bit_floor(measureGroupSize);
+}
+
+OpenClBackend::~OpenClBackend()
+{
+    _queue.finish();
+
+    for (auto& slot : _readbacks) {
+        if (slot.host != nullptr) {
+            _transfer.enqueue_unmap_buffer(slot.pinned, slot.host);
+        }
+    }
+    _transfer.finish();
+
+    collect(true);
+}
+
+std::string OpenClBackend::name() const
+{
+    return "OpenCL (" + _queue.get_device().name() + ")";
+}
+
+Precision OpenClBackend::setPrecision(Stage stage, Precision precision)
+{
+    if (precision == Precision::Double && !_device->supportsDouble()) {
+        precision = Precision::Mixed;
+    }
+
+    /// the force field kernel is built on first use, so that runs with the FFT field never
+    /// build a program of its precision.
+    if (stage == Stage::ForceField) {
+        if (std::exchange(_precision[std::size_t(stage)], precision) != precision) {
+            _forceFieldKernel = compute::kernel();
+        }
+        return precision;
+    }
+
+    _precision[std::size_t(stage)] = precision;
+
+    const auto& program = _device->program(precision);
+    _iterateKernel      = program.create_kernel("iterate");
+    _tiledKernel        = program.create_kernel("iterateTiled");
+    _barnesHutKernel    = program.create_kernel("iterateBarnesHut");
+    _particleMeshKernel = program.create_kernel("iterateParticleMesh");
+    _bound = false;
+
+    _maxTileSize = _tiledKernel.get_work_group_info<std::size_t>(_queue.get_device(), CL_KERNEL_WORK_GROUP_SIZE);
+    return precision;
+}
+
+void OpenClBackend::computeForceField(const std::vector<f32>& values, u32 width, u32 height)
+{
+    _width  = width;
+    _height = height;
+
+    if (_forceFieldKernel.get() == nullptr) {
+        _forceFieldKernel = _device->program(_precision[std::size_t(Stage::ForceField)])
+                                .create_kernel("computeForceField");
+    }
+
+    _values_dev.resize(values.size(), _queue);
+    upload(_values_dev.get_buffer(), 0, values.data(), values.size() * sizeof(f32), "upload values");
+
+    _forceField.resize((width + 2) * (height + 2), _queue);
+    compute::fill(_forceField.begin(), _forceField.end(), compute::float2_(0, 0), _queue);
+
+    _forceFieldKernel.set_arg(0, _values_dev.get_buffer());
+    _forceFieldKernel.set_arg(1, _forceField.get_buffer());
+    _forceFieldKernel.set_arg(2, width);
+    _forceFieldKernel.set_arg(3, height);
+
+    const auto pixels = std::size_t(width) * height;
+    auto launch = [&](const Setting& setting) {
+        return _queue.enqueue_1d_range_kernel(_forceFieldKernel, 0, padded(pixels, setting.local), setting.local);
+    };
+    const auto candidates = pixels <= maxTunedForceFieldPixels ? localSizes(_forceFieldKernel) : std::vector<Setting>{};
+    const auto setting    = tuned("computeForceField", Stage::ForceField, pixels, candidates, {}, launch);
+    profile("computeForceField", Profiler::Category::Kernel, launch(setting));
+
+    _bound = false;
+}
+
+void OpenClBackend::setForceField(std::span<const f32> field, u32 width, u32 height)
+{
+    _width  = width;
+    _height = height;
+
+    _forceField.resize((width + 2) * (height + 2), _queue);
+    compute::fill(_forceField.begin(), _forceField.end(), compute::float2_(0, 0), _queue);
+
+    /// interleaved (x, y) pairs share the memory layout of float2.
+    upload(_forceField.get_buffer(), 0, field.data(), field.size() * sizeof(f32), "setForceField");
+
+    _bound = false;
+}
+
+void OpenClBackend::forceField(std::vector<f32>& field)
+{
+    field.resize(2 * _width * _height);
+    profile("forceField", Profiler::Category::Transfer,
+            _queue.enqueue_read_buffer(_forceField.get_buffer(), 0, field.size() * sizeof(f32), field.data()));
+    collect(false);
+}
+
+void OpenClBackend::setParticles(const std::vector<compute::float2_>& points)
+{
+    _particles_k0.resize(points.size(), _queue);
+    _particles_k1.resize(points.size(), _queue);
+
+    upload(_particles_k0.get_buffer(), 0, points.data(), points.size() * sizeof(compute::float2_), "setParticles");
+}
+
+void OpenClBackend::particles(std::vector<compute::float2_>& points)
+{
+    points.resize(_particles_k0.size());
+    profile("particles", Profiler::Category::Transfer,
+            _queue.enqueue_read_buffer(_particles_k0.get_buffer(), 0, points.size() * sizeof(compute::float2_),
+                                       points.data()));
+    collect(false);
+}
+
+void OpenClBackend::beginReadback()
+{
+    Q_ASSERT(_pendingReadbacks < _readbacks.size());
+
+    auto& slot = _readbacks[(_firstReadback + _pendingReadbacks) % _readbacks.size()];
+    const auto bytes = _particles_k0.size() * sizeof(compute::float2_);
+    reserve(slot, bytes);
+    slot.count = _particles_k0.size();
+
+    /// the snapshot is ordered with the iterations; the transfer queue only waits for it,
+    /// and the positions themselves are free to be overwritten by the next iterations.
+    const auto copied = _queue.enqueue_copy_buffer(_particles_k0.get_buffer(), slot.staging, 0, 0, bytes);
+    _queue.flush();
+    profile("snapshot", Profiler::Category::Transfer, copied);
+
+    slot.done = _transfer.enqueue_read_buffer_async(slot.staging, 0, bytes, slot.host, copied);
+    _transfer.flush();
+    profile("readback", Profiler::Category::Transfer, slot.done, true);
+
+    _pendingReadbacks++;
+}
+
+bool OpenClBackend::finishReadback(std::vector<compute::float2_>& points)
+{
+    if (_pendingReadbacks == 0) {
+        return false;
+    }
+
+    auto& slot = _readbacks[_firstReadback];
+    slot.done.wait();
+
+    const auto* host = static_cast<const compute::float2_*>(slot.host);
+    points.assign(host, host + slot.count);
+
+    _firstReadback = (_firstReadback + 1) % _readbacks.size();
+    _pendingReadbacks--;
+
+    collect(false);
+    return true;
+}
+
+void OpenClBackend::finish()
+{
+    _queue.finish();
+    _transfer.finish();
+}
+
+void OpenClBackend::setDensity(const AliasTable& table, u32 width)
+{
+    _densityWidth = width;
+
+    const auto& probabilities = table.probabilities();
+    const auto& aliases       = table.aliases();
+    _densityProbabilities.resize(probabilities.size(), _queue);
+    _densityAliases.resize(aliases.size(), _queue);
+    upload(_densityProbabilities.get_buffer(), 0, probabilities.data(), probabilities.size() * sizeof(f32),
+           "setDensity");
+    upload(_densityAliases.get_buffer(), 0, aliases.data(), aliases.size() * sizeof(u32), "setDensity");
+}
+
+void OpenClBackend::seedParticles(u32 count, u64 seed)
+{
+    const auto key = philoxKey(seed);
+
+    _particles_k0.resize(count, _queue);
+    _particles_k1.resize(count, _queue);
+
+    _seedKernel.set_arg(0, _particles_k0.get_buffer());
+    _seedKernel.set_arg(1, _densityProbabilities.get_buffer());
+    _seedKernel.set_arg(2, _densityAliases.get_buffer());
+    _seedKernel.set_arg(3, u32(_densityProbabilities.size()));
+    _seedKernel.set_arg(4, _densityWidth);
+    _seedKernel.set_arg(5, compute::uint2_(key[0], key[1]));
+    profile("seedParticles", Profiler::Category::Kernel, _queue.enqueue_1d_range_kernel(_seedKernel, 0, count, 0));
+}
+
+void OpenClBackend::shake(u64 seed, u32 iteration, f32 magnitude)
+{
+    const auto key = philoxKey(seed);
+
+    _shakeKernel.set_arg(0, _particles_k0.get_buffer());
+    _shakeKernel.set_arg(1, compute::uint2_(key[0], key[1]));
+    _shakeKernel.set_arg(2, iteration);
+    _shakeKernel.set_arg(3, magnitude);
+    profile("shake", Profiler::Category::Kernel,
+            _queue.enqueue_1d_range_kernel(_shakeKernel, 0, _particles_k0.size(), 0));
+}
+
+void OpenClBackend::beginMeasure()
+{
+    Q_ASSERT(_pendingMeasures < _measuredHost.size());
+
+    const auto slot   = (_firstMeasure + _pendingMeasures) % u32(_measuredHost.size());
+    const auto n      = u32(_particles_k0.size());
+    const auto local  = _measureGroupSize;
+    const auto groups = std::clamp<std::size_t>((n + local - 1) / local, 1, 64);
+
+    _measurePartials.resize(groups, _queue);
+
+    /// the last iterate* call read _particles_k1 and wrote _particles_k0.
+    _measureKernel.set_arg(0, _particles_k1.get_buffer());
+    _measureKernel.set_arg(1, _particles_k0.get_buffer());
+    _measureKernel.set_arg(2, n);
+    _measureKernel.set_arg(3, _measurePartials.get_buffer());
+    _measureKernel.set_arg(4, compute::local_buffer<compute::float4_>(local));
+    profile("measureDisplacement", Profiler::Category::Kernel,
+            _queue.enqueue_1d_range_kernel(_measureKernel, 0, groups * local, local));
+
+    _reduceKernel.set_arg(0, _measurePartials.get_buffer());
+    _reduceKernel.set_arg(1, u32(groups));
+    _reduceKernel.set_arg(2, _measured.get_buffer());
+    _reduceKernel.set_arg(3, slot);
+    _reduceKernel.set_arg(4, compute::local_buffer<compute::float4_>(local));
+    profile("reduceDisplacement", Profiler::Category::Kernel,
+            _queue.enqueue_1d_range_kernel(_reduceKernel, 0, local, local));
+
+    _measuredCount[slot] = n;
+    _measureDone[slot]   = _queue.enqueue_read_buffer_async(_measured.get_buffer(), slot * sizeof(compute::float4_),
+                                                            sizeof(compute::float4_), &_measuredHost[slot]);
+    _queue.flush();
+    profile("measured", Profiler::Category::Transfer, _measureDone[slot]);
+
+    _pendingMeasures++;
+}
+
+Convergence OpenClBackend::finishMeasure()
+{
+    Q_ASSERT(_pendingMeasures > 0);
+
+    const auto slot = _firstMeasure;
+    _measureDone[slot].wait();
+
+    const auto& measured = _measuredHost[slot];
+    _firstMeasure = (_firstMeasure + 1) % u32(_measuredHost.size());
+    _pendingMeasures--;
+
+    collect(false);
+
+    return {measured.x, measured.y / std::max(1u, _measuredCount[slot]), measured.z / 2};
+}
+
+void OpenClBackend::iterateExact(const Step& step)
+{
+    const auto [first, count] = slice();
+
+    bind(step);
+    _iterateKernel.set_arg(6, u32(_particles_k0.size()));
+    _iterateKernel.set_arg(7, first + count);
+    advance(_iterateKernel, "iterate", first, count, localSizes(_iterateKernel), {},
+            [&](const Setting& setting) { return padded(count, setting.local); });
+}
+
+void OpenClBackend::iterateTiled(const Step& step, u32 tileSize, u32 particlesPerItem)
+{
+    const auto n = u32(_particles_k0.size());
+    const auto [first, count] = slice();
+
+    /// the tile is the work-group, so the driver cannot choose its size.
+    std::vector<Setting> candidates;
+    for (const auto& size : localSizes(_tiledKernel, false)) {
+        for (const u32 perItem : {1u, 2u, 4u}) {
+            candidates.push_back({size.local, perItem});
+        }
+    }
+    const Setting fallback{u32(std::min<std::size_t>(tileSize, _maxTileSize)), particlesPerItem};
+
+    bind(step);
+    _tiledKernel.set_arg(6, n);
+    _tiledKernel.set_arg(9, first + count);
+
+    advance(_tiledKernel, "iterateTiled", first, count, candidates, fallback, [&](const Setting& setting) {
+        _tiledKernel.set_arg(7, setting.perItem);
+        _tiledKernel.set_arg(8, compute::local_buffer<compute::float2_>(setting.local));
+        return padded((count + setting.perItem - 1) / setting.perItem, setting.local);
+    });
+}
+
+void OpenClBackend::iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta)
+{
+    const auto& nodes = tree.nodes();
+    _treeNodes.resize(nodes.size(), _queue);
+    _treeLinks.resize(nodes.size(), _queue);
+    _treePoints.resize(tree.points().size(), _queue);
+    upload(_treeNodes.get_buffer(), 0, nodes.data(), nodes.size() * sizeof(compute::float4_), "upload tree");
+    upload(_treeLinks.get_buffer(), 0, tree.links().data(), tree.links().size() * sizeof(compute::uint4_),
+           "upload tree");
+    upload(_treePoints.get_buffer(), 0, tree.points().data(), tree.points().size() * sizeof(compute::float2_),
+           "upload tree");
+
+    bind(step);
+    _barnesHutKernel.set_arg(6, _treeNodes.get_buffer());
+    _barnesHutKernel.set_arg(7, _treeLinks.get_buffer());
+    _barnesHutKernel.set_arg(8, u32(nodes.size()));
+    _barnesHutKernel.set_arg(9, _treePoints.get_buffer());
+    _barnesHutKernel.set_arg(10, theta);
+
+    const auto [first, count] = slice();
+    _barnesHutKernel.set_arg(11, first + count);
+    advance(_barnesHutKernel, "iterateBarnesHut", first, count, localSizes(_barnesHutKernel), {},
+            [&](const Setting& setting) { return padded(count, setting.local); });
+}
+
+void OpenClBackend::iterateParticleMesh(const Step& step, const ParticleMesh& mesh)
+{
+    /// same layout and padding as the force field, so bilinear() can sample it.
+    const auto& field = mesh.field();
+    _meshField.resize(_forceField.size(), _queue);
+    compute::fill(_meshField.begin(), _meshField.end(), compute::float2_(0, 0), _queue);
+    upload(_meshField.get_buffer(), 0, field.data(), field.size() * sizeof(f32), "upload mesh");
+
+    const auto& starts = mesh.cellStarts();
+    const auto& points = mesh.points();
+    _cellStarts.resize(starts.size(), _queue);
+    _cellPoints.resize(points.size(), _queue);
+    upload(_cellStarts.get_buffer(), 0, starts.data(), starts.size() * sizeof(u32), "upload mesh");
+    upload(_cellPoints.get_buffer(), 0, points.data(), points.size() * sizeof(compute::float2_), "upload mesh");
+
+    const compute::uint2_ cells{mesh.cellColumns(), mesh.cellRows()};
+
+    bind(step);
+    _particleMeshKernel.set_arg(6, _meshField.get_buffer());
+    _particleMeshKernel.set_arg(7, _cellStarts.get_buffer());
+    _particleMeshKernel.set_arg(8, _cellPoints.get_buffer());
+    _particleMeshKernel.set_arg(9, cells);
+    _particleMeshKernel.set_arg(10, mesh.cutoff());
+
+    const auto [first, count] = slice();
+    _particleMeshKernel.set_arg(11, first + count);
+    advance(_particleMeshKernel, "iterateParticleMesh", first, count, localSizes(_particleMeshKernel), {},
+            [&](const Setting& setting) { return padded(count, setting.local); });
+}
+
+void OpenClBackend::setSlice(u32 first, u32 count)
+{
+    _sliceFirst = first;
+    _sliceCount = count;
+}
+
+compute::event OpenClBackend::beginReadSlice(std::vector<compute::float2_>& points)
+{
+    const auto [first, count] = slice();
+    Q_ASSERT(points.size() == _particles_k0.size());
+
+    const auto event = _queue.enqueue_read_buffer_async(_particles_k0.get_buffer(), first * sizeof(compute::float2_),
+                                                        count * sizeof(compute::float2_), points.data() + first);
+    _queue.flush();
+    profile("readSlice", Profiler::Category::Transfer, event);
+    return event;
+}
+
+compute::event OpenClBackend::beginWriteParticles(const std::vector<compute::float2_>& points, u32 first, u32 count)
+{
+    Q_ASSERT(points.size() == _particles_k0.size() && first + count <= points.size());
+
+    const auto event = _queue.enqueue_write_buffer_async(_particles_k0.get_buffer(), first * sizeof(compute::float2_),
+                                                         count * sizeof(compute::float2_), points.data() + first);
+    _queue.flush();
+    profile("writeParticles", Profiler::Category::Transfer, event);
+    return event;
+}
+
+std::chrono::nanoseconds OpenClBackend::lastIterationTime() const
+{
+    return _lastIteration.get() != nullptr ? _lastIteration.duration<std::chrono::nanoseconds>()
+                                           : std::chrono::nanoseconds(0);
+}
+
+void OpenClBackend::setProfiler(std::shared_ptr<Profiler> profiler)
+{
+    collect(true);
+
+    const auto wasProfiled = profiled();
+    _profiler = std::move(profiler);
+    if (profiled() != wasProfiled) {
+        _queue.finish();
+        _transfer.finish();
+        _queue    = compute::command_queue(_context, _device->device(), queueProperties(profiled()));
+        _transfer = compute::command_queue(_context, _device->device(), queueProperties(profiled()));
+    }
+
+    if (_profiler) {
+        /// one pair of tracks per backend, so that concurrent backends on a device stay apart.
+        static std::atomic<u32> backends{0};
+        const auto index = std::to_string(backends++);
+        const auto name  = _queue.get_device().name();
+        _computeTrack    = _profiler->track(name, "compute " + index);
+        _transferTrack   = _profiler->track(name, "transfer " + index);
+    }
+}
+
+std::pair<u32, u32> OpenClBackend::slice() const
+{
+    const auto n = u32(_particles_k0.size());
+    if (_sliceCount == 0) {
+        return {0, n};
+    }
+    const auto first = std::min(_sliceFirst, n);
+    return {first, std::min(_sliceCount, n - first)};
+}
+
+void OpenClBackend::bind(const Step& step)
+{
+    if (_bound && step.boundry == _step.boundry && step.radius == _step.radius) {
+        return;
+    }
+
+    for (auto* kernel : {&_iterateKernel, &_tiledKernel, &_barnesHutKernel, &_particleMeshKernel}) {
+        kernel->set_arg(2, _forceField.get_buffer());
+        kernel->set_arg(3, _width);
+        kernel->set_arg(4, step.boundry);
+        kernel->set_arg(5, step.radius);
+    }
+
+    _step  = step;
+    _bound = true;
+}
+
+void OpenClBackend::reserve(Readback& slot, std::size_t bytes)
+{
+    if (slot.capacity >= bytes) {
+        return;
+    }
+
+    if (slot.host != nullptr) {
+        _transfer.enqueue_unmap_buffer(slot.pinned, slot.host).wait();
+    }
+
+    /// allocated by the driver in host memory it can transfer to directly, and mapped for good.
+    slot.staging  = compute::buffer(_context, bytes, compute::buffer::read_write);
+    slot.pinned   = compute::buffer(_context, bytes, compute::buffer::read_write | compute::buffer::alloc_host_ptr);
+    slot.host     = _transfer.enqueue_map_buffer(slot.pinned, CL_MAP_READ | CL_MAP_WRITE, 0, bytes);
+    slot.capacity = bytes;
+}
+
+void OpenClBackend::upload(const compute::buffer& buffer, std::size_t offset, const void* host, std::size_t bytes,
+                           const char* name)
+{
+    if (bytes > 0) {
+        profile(name, Profiler::Category::Transfer, _queue.enqueue_write_buffer(buffer, offset, bytes, host));
+    }
+}
+
+void OpenClBackend::profile(const char* name, Profiler::Category category, const compute::event& event, bool transfer)
+{
+    if (!_profiler) {
+        return;
+    }
+    _profiled.push_back({name, category, transfer ? _transferTrack : _computeTrack, event});
+
+    /// a run that never reads back still has its finished commands collected now and then.
+    if (_profiled.size() >= 4096) {
+        collect(false);
+    }
+}
+
+void OpenClBackend::collect(bool wait)
+{
+    if (!_profiler) {
+        _profiled.clear();
+        return;
+    }
+
+    std::erase_if(_profiled, [&](Profiled& profiled) {
+        if (wait) {
+            profiled.event.wait();
+        } else if (profiled.event.status() != CL_COMPLETE) {
+            return false;
+        }
+
+        auto time = [&](cl_profiling_info info) { return u64(profiled.event.get_profiling_info<cl_ulong>(info)); };
+        _profiler->add({profiled.track, std::move(profiled.name), profiled.category, time(CL_PROFILING_COMMAND_QUEUED),
+                        time(CL_PROFILING_COMMAND_SUBMIT), time(CL_PROFILING_COMMAND_START),
+                        time(CL_PROFILING_COMMAND_END)});
+        return true;
+    });
+}
+
+template <typename Configure>
+void OpenClBackend::advance(compute::kernel& kernel, const char* name, std::size_t offset, std::size_t items,
+                            const std::vector<Setting>& candidates, const Setting& fallback, Configure configure)
+{
+    /// candidates write the same result, so timing them leaves nothing behind.
+    auto launch = [&](const Setting& setting) {
+        kernel.set_arg(0, _particles_k0.get_buffer());
+        kernel.set_arg(1, _particles_k1.get_buffer());
+        const auto global = configure(setting);
+        return _queue.enqueue_1d_range_kernel(kernel, offset, global, setting.local);
+    };
+
+    const auto event = launch(tuned(name, Stage::Repulsion, items, candidates, fallback, launch));
+    if (_timed) {
+        _lastIteration = event;
+    }
+    profile(name, Profiler::Category::Kernel, event);
+
+    _particles_k0.swap(_particles_k1);
+}
+
+template <typename Launch>
+OpenClBackend::Setting OpenClBackend::tuned(const char* name, Stage stage, std::size_t items,
+                                            const std::vector<Setting>& candidates, const Setting& fallback,
+                                            Launch launch)
+{
+    auto& profile        = _device->workGroups();
+    const auto precision = _precision[std::size_t(stage)];
+
+    if (const auto setting = profile.find(name, precision, items)) {
+        return *setting;
+    }
+    if (!_device->autotune() || candidates.empty()) {
+        return fallback;
+    }
+
+    /// the first launch pays for whatever the driver does lazily and is not timed. a candidate
+    /// is judged by the median of a few launches, as a single one on a shared device is mostly
+    /// noise, and the winner is kept for good.
+    constexpr std::size_t samples = 5;
+    std::optional<Setting> best;
+    auto fastest = std::chrono::nanoseconds::max();
+    auto warm    = false;
+    for (const auto& candidate : candidates) {
+        try {
+            if (!std::exchange(warm, true)) {
+                launch(candidate).wait();
+            }
+            std::array<std::chrono::nanoseconds, samples> times;
+            for (auto& time : times) {
+                auto event = launch(candidate);
+                event.wait();
+                time = event.duration<std::chrono::nanoseconds>();
+            }
+            std::ranges::nth_element(times, times.begin() + samples / 2);
+
+            if (const auto time = times[samples / 2]; time < fastest) {
+                fastest = time;
+                best    = candidate;
+            }
+        } catch (const compute::opencl_error&) {
+            /// a size the kernel cannot run with here, e.g. for lack of registers or local memory.
+            warm = false;
+        }
+    }
+    if (!best) {
+        return fallback;
+    }
+
+    if (!profile.store(name, precision, items, *best)) {
+        std::println(stderr, "cannot write the work-group profile {}", profile.path().toStdString());
+    }
+    return *best;
+}
+
+std::vector<OpenClBackend::Setting> OpenClBackend::localSizes(const compute::kernel& kernel, bool driver) const
+{
+    const auto max = std::min<std::size_t>(
+        1024, kernel.get_work_group_info<std::size_t>(_queue.get_device(), CL_KERNEL_WORK_GROUP_SIZE));
+
+    std::vector<Setting> sizes;
+    if (driver) {
+        sizes.push_back({0, 1});
+    }
+    for (std::size_t local = 32; local <= max; local *= 2) {
+        sizes.push_back({u32(local), 1});
+    }
+    return sizes;
+}
@@ -0,0 +1,238 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "Backend.hpp"
+#include "Device.hpp"
+
+#include <boost/compute/buffer.hpp>
+#include <boost/compute/command_queue.hpp>
+#include <boost/compute/container/vector.hpp>
+#include <boost/compute/context.hpp>
+#include <boost/compute/event.hpp>
+#include <boost/compute/kernel.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace core
+{
+    /// runs the kernels in kernels.cl on an OpenCL device.
+    ///
+    /// the device, its context and the built program may be shared with other
+    /// backends; the queue, the buffers and the kernels belong to this one.
+    ///
+    /// kernels are created once and work is only enqueued, never waited for, so any
+    /// number of iterations run back-to-back on the device; the host synchronises
+    /// only when it reads something back.
+    class OpenClBackend final : public Backend
+    {
+    public:
+        /// timed records the device time of every iterate* call for lastIterationTime. the queues
+        /// only record timestamps if timed, while the device autotunes or while a profiler is
+        /// attached; otherwise the driver is spared their cost.
+        explicit OpenClBackend(std::shared_ptr<const Device> device, bool timed = false);
+
+        /// waits for the work still in the queue.
+        ~OpenClBackend() override;
+
+        std::string name() const override;
+
+        /// double falls back to mixed on devices without cl_khr_fp64. kernels.cl is built once
+        /// per precision and shared through the Device.
+        Precision setPrecision(Stage stage, Precision precision) override;
+
+        void computeForceField(const std::vector<f32>& values, u32 width, u32 height) override;
+
+        void setForceField(std::span<const f32> field, u32 width, u32 height) override;
+
+        void forceField(std::vector<f32>& field) override;
+
+        void setParticles(const std::vector<compute::float2_>& points) override;
+
+        void particles(std::vector<compute::float2_>& points) override;
+
+        /// snapshots the positions into a device buffer on the compute queue, then streams the
+        /// snapshot into pinned host memory on a separate transfer queue, so the next
+        /// iterations compute while it is in flight.
+        void beginReadback() override;
+
+        bool finishReadback(std::vector<compute::float2_>& points) override;
+
+        void finish() override;
+
+        void setDensity(const AliasTable& table, u32 width) override;
+
+        void seedParticles(u32 count, u64 seed) override;
+
+        void shake(u64 seed, u32 iteration, f32 magnitude) override;
+
+        void beginMeasure() override;
+
+        Convergence finishMeasure() override;
+
+        void iterateExact(const Step& step) override;
+
+        /// tileSize and particlesPerItem only apply until the device's work-group profile has
+        /// a setting for the kernel and this many particles.
+        void iterateTiled(const Step& step, u32 tileSize, u32 particlesPerItem) override;
+
+        void iterateBarnesHut(const Step& step, const QuadTree& tree, f32 theta) override;
+
+        void iterateParticleMesh(const Step& step, const ParticleMesh& mesh) override;
+
+        /// restricts the iterate* calls to the particles [first, first + count), which then
+        /// leave the others unspecified until they are replaced; count 0 advances all of them.
+        /// lets several backends share one set of particles, see MultiDeviceBackend.
+        void setSlice(u32 first, u32 count);
+
+        /// starts copying the slice into the same range of points, which holds every particle,
+        /// and returns without waiting.
+        compute::event beginReadSlice(std::vector<compute::float2_>& points);
+
+        /// starts replacing the particles [first, first + count) with the same range of points,
+        /// which holds every particle and must stay unchanged until the returned event completes.
+        compute::event beginWriteParticles(const std::vector<compute::float2_>& points, u32 first, u32 count);
+
+        /// device time of the last iterate* call if the backend is timed, otherwise 0.
+        std::chrono::nanoseconds lastIterationTime() const;
+
+        /// every kernel and transfer, on the compute queue and the transfer queue, one track each.
+        /// the timestamps are collected once their commands completed, whenever the host waits
+        /// for the device anyway. the queues are replaced if they have to start or may stop
+        /// recording timestamps.
+        void setProfiler(std::shared_ptr<Profiler> profiler) override;
+
+    private:
+        /// sets the force field, width and step arguments of every iterate kernel, unless
+        /// they are already bound.
+        void bind(const Step& step);
+
+        /// the particles the iterate* calls advance, as first and count.
+        std::pair<u32, u32> slice() const;
+
+        using Setting = WorkGroupProfile::Setting;
+
+        /// runs kernel over the particles [offset, offset + items) with the work-group setting
+        /// the device has for it (see tuned), and makes its result the current positions.
+        /// configure sets the arguments that depend on the setting and returns the global size.
+        template <typename Configure>
+        void advance(compute::kernel& kernel, const char* name, std::size_t offset, std::size_t items,
+                     const std::vector<Setting>& candidates, const Setting& fallback, Configure configure);
+
+        /// the setting the device's profile has for the kernel called name over items work-items
+        /// in the precision of stage. if there is none and the device autotunes, every candidate
+        /// is launched and timed once, and the fastest is stored; otherwise fallback.
+        template <typename Launch>
+        Setting tuned(const char* name, Stage stage, std::size_t items, const std::vector<Setting>& candidates,
+                      const Setting& fallback, Launch launch);
+
+        /// the driver's choice and the powers of two from 32 up to what kernel allows on the device.
+        std::vector<Setting> localSizes(const compute::kernel& kernel, bool driver = true) const;
+
+        /// one readback slot: a device snapshot of the positions and the mapped, pinned host
+        /// memory it is read into.
+        struct Readback
+        {
+            compute::buffer staging;
+            compute::buffer pinned;
+            void* host{nullptr};
+            std::size_t capacity{0};
+            std::size_t count{0};
+            compute::event done;
+        };
+
+        /// makes slot hold at least bytes.
+        void reserve(Readback& slot, std::size_t bytes);
+
+        /// copies bytes from host to offset in buffer, waiting for the copy; profiled as name.
+        void upload(const compute::buffer& buffer, std::size_t offset, const void* host, std::size_t bytes,
+                    const char* name);
+
+        /// keeps event for the profiler, if there is one; transfer tells the queue it is on.
+        void profile(const char* name, Profiler::Category category, const compute::event& event,
+                     bool transfer = false);
+
+        /// whether the queues have to record timestamps.
+        bool profiled() const { return _timed || _device->autotune() || _profiler != nullptr; }
+
+        /// hands the timestamps of the completed profiled commands to the profiler, or of all
+        /// of them after waiting if wait is set.
+        void collect(bool wait);
+
+        /// a command waiting to be collected.
+        struct Profiled
+        {
+            std::string name;
+            Profiler::Category category;
+            u32 track;
+            compute::event event;
+        };
+
+        u32 _width{1};
+        u32 _height{1};
+        u32 _densityWidth{1};
+        std::size_t _maxTileSize{1};
+        std::array<Precision, 2> _precision{Precision::Double, Precision::Float}; ///< indexed by Stage.
+        Step _step{};
+        bool _bound{false};
+        bool _timed{false};
+        u32 _sliceFirst{0};
+        u32 _sliceCount{0};
+        compute::event _lastIteration;
+
+        std::shared_ptr<const Device> _device;
+        compute::context _context;
+        compute::command_queue _queue;
+        compute::command_queue _transfer;
+
+        compute::vector<compute::float2_> _forceField;
+        compute::vector<compute::float2_> _particles_k0;
+        compute::vector<compute::float2_> _particles_k1;
+        compute::vector<compute::float4_> _treeNodes;
+        compute::vector<compute::uint4_> _treeLinks;
+        compute::vector<compute::float2_> _treePoints;
+        compute::vector<compute::float2_> _meshField;
+        compute::vector<u32> _cellStarts;
+        compute::vector<compute::float2_> _cellPoints;
+        compute::vector<f32> _values_dev;
+        compute::vector<f32> _densityProbabilities;
+        compute::vector<u32> _densityAliases;
+
+        std::array<Readback, 2> _readbacks;
+        u32 _firstReadback{0};
+        u32 _pendingReadbacks{0};
+
+        /// measurements are reduced on the device into one float4 (max, sum, sum of squares)
+        /// per slot and read asynchronously.
+        compute::vector<compute::float4_> _measurePartials;
+        compute::vector<compute::float4_> _measured;
+        std::size_t _measureGroupSize{1};
+        std::array<compute::float4_, 2> _measuredHost{};
+        std::array<u32, 2> _measuredCount{};
+        std::array<compute::event, 2> _measureDone;
+        u32 _firstMeasure{0};
+        u32 _pendingMeasures{0};
+
+        std::shared_ptr<Profiler> _profiler;
+        u32 _computeTrack{0};
+        u32 _transferTrack{0};
+        std::vector<Profiled> _profiled;
+
+        compute::kernel _forceFieldKernel; ///< built by computeForceField, empty until then.
+        compute::kernel _iterateKernel;
+        compute::kernel _tiledKernel;
+        compute::kernel _barnesHutKernel;
+        compute::kernel _particleMeshKernel;
+        compute::kernel _shakeKernel;
+        compute::kernel _seedKernel;
+        compute::kernel _measureKernel;
+        compute::kernel _reduceKernel;
+    };
+}
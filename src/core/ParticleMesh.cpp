@@ -0,0 +1,95 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "ParticleMesh.hpp"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+
+
+using namespace core;
+
+namespace
+{
+    /// smootherstep, 0 at the origin and 1 from x = 1 on; its x^3 leading term keeps green * S continuous.
+    f64 smootherstep(f64 x)
+    {
+        x = std::clamp(x, 0.0, 1.0);
+        return x * x * x * (x * (6 * x - 15) + 10);
+    }
+}
+
+ParticleMesh::ParticleMesh(f32 cutoff)
+    : _cutoff(cutoff)
+    , _longRange([cutoff](f64 dx, f64 dy) {
+        const auto g = coulomb(dx, dy);
+        const auto s = smootherstep(std::sqrt(dx*dx + dy*dy) / cutoff);
+        return Green{g.x * s, g.y * s};
+    })
+{
+    Q_ASSERT(cutoff > 0);
+}
+
+void ParticleMesh::build(const std::vector<compute::float2_>& points, u32 width, u32 height)
+{
+    _width  = width;
+    _height = height;
+
+    splat(points);
+    _field = _longRange.apply(_density, width, height);
+    sortIntoCells(points);
+}
+
+void ParticleMesh::splat(const std::vector<compute::float2_>& points)
+{
+    _density.assign(std::size_t(_width) * _height, 0.f);
+
+    auto deposit = [this](u32 row, u32 col, f32 weight) {
+        if (row < _height && col < _width && weight > 0) {
+            _density[std::size_t(row) * _width + col] += weight;
+        }
+    };
+
+    /// the same weights as bilinear() in kernels.cl, so a particle exerts no force on itself.
+    for (const auto& p : points) {
+        const auto col = u32(std::floor(p.x));
+        const auto row = u32(std::floor(p.y));
+        const auto fx  = p.x - col;
+        const auto fy  = p.y - row;
+
+        deposit(row,     col,     (1 - fx) * (1 - fy));
+        deposit(row,     col + 1, fx * (1 - fy));
+        deposit(row + 1, col,     (1 - fx) * fy);
+        deposit(row + 1, col + 1, fx * fy);
+    }
+}
+
+void ParticleMesh::sortIntoCells(const std::vector<compute::float2_>& points)
+{
+    _cellColumns = u32(std::ceil(_width / _cutoff)) + 1;
+    _cellRows    = u32(std::ceil(_height / _cutoff)) + 1;
+
+    auto cellOf = [this](const compute::float2_& p) {
+        const auto col = std::min(u32(p.x / _cutoff), _cellColumns - 1);
+        const auto row = std::min(u32(p.y / _cutoff), _cellRows - 1);
+        return row * _cellColumns + col;
+    };
+
+    /// counting sort by cell.
+    _cellStarts.assign(std::size_t(_cellColumns) * _cellRows + 1, 0);
+    for (const auto& p : points) {
+        _cellStarts[cellOf(p) + 1]++;
+    }
+    for (std::size_t i = 1; i < _cellStarts.size(); ++i) {
+        _cellStarts[i] += _cellStarts[i - 1];
+    }
+
+    auto offsets = std::vector<u32>(_cellStarts.begin(), _cellStarts.end() - 1);
+    _points.resize(points.size());
+    for (const auto& p : points) {
+        _points[offsets[cellOf(p)]++] = p;
+    }
+}
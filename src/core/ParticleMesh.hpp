@@ -0,0 +1,65 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+#include "ForceField.hpp"
+
+#include <boost/compute/types/fundamental.hpp>
+
+#include <vector>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// particle-particle/particle-mesh (P3M) split of the push force.
+    ///
+    /// the 1/r^2 interaction is split into a smooth long-range part, green * S(r/cutoff),
+    /// and a short-range remainder, green * (1 - S(r/cutoff)), where S is the smootherstep.
+    /// the long-range part is obtained by splatting the particles onto the pixel grid with
+    /// bilinear weights, convolving, and sampling the resulting field with the same weights.
+    /// the short-range part is summed exactly over the neighbours found in a uniform cell
+    /// list whose cells are as wide as the cutoff.
+    class ParticleMesh
+    {
+    public:
+        explicit ParticleMesh(f32 cutoff = 4);
+
+        void build(const std::vector<compute::float2_>& points, u32 width, u32 height);
+
+        f32 cutoff() const { return _cutoff; }
+
+        /// interleaved (x, y) long-range push field, row-major with a stride of width.
+        const std::vector<f32>& field() const { return _field; }
+
+        /// particles of cell i are points()[cellStarts()[i] .. cellStarts()[i+1]).
+        const std::vector<u32>& cellStarts() const { return _cellStarts; }
+
+        const std::vector<compute::float2_>& points() const { return _points; }
+
+        u32 cellColumns() const { return _cellColumns; }
+
+        u32 cellRows() const { return _cellRows; }
+
+    private:
+        void splat(const std::vector<compute::float2_>& points);
+
+        void sortIntoCells(const std::vector<compute::float2_>& points);
+
+        f32 _cutoff;
+        u32 _width{0};
+        u32 _height{0};
+        u32 _cellColumns{0};
+        u32 _cellRows{0};
+        FieldConvolution _longRange;
+        std::vector<f32> _density;
+        std::vector<f32> _field;
+        std::vector<u32> _cellStarts;
+        std::vector<compute::float2_> _points;
+    };
+}
@@ -0,0 +1,55 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+
+
+namespace core
+{
+    /// Philox4x32-10 counter-based generator, "Parallel random numbers: as easy as 1, 2, 3"
+    /// (Salmon et al., SC11). every counter gives four independent 32-bit numbers, so each
+    /// particle draws from its own stream without any generator state.
+    ///
+    /// philox(), uniform() and scale() match the functions of the same name in kernels.cl
+    /// bit for bit, so both backends draw the same numbers from the same seed.
+    using PhiloxCounter = std::array<u32, 4>;
+    using PhiloxKey     = std::array<u32, 2>;
+
+    inline PhiloxKey philoxKey(u64 seed)
+    {
+        return {u32(seed), u32(seed >> 32)};
+    }
+
+    inline PhiloxCounter philox(PhiloxCounter counter, PhiloxKey key)
+    {
+        constexpr u64 m0 = 0xD2511F53;
+        constexpr u64 m1 = 0xCD9E8D57;
+
+        for (u32 round = 0; round < 10; ++round) {
+            const auto p0 = m0 * counter[0];
+            const auto p1 = m1 * counter[2];
+            counter = {u32(p1 >> 32) ^ counter[1] ^ key[0], u32(p1),
+                       u32(p0 >> 32) ^ counter[3] ^ key[1], u32(p0)};
+            key[0] += 0x9E3779B9;
+            key[1] += 0xBB67AE85;
+        }
+        return counter;
+    }
+
+    /// [0, 1) from the upper 24 bits of x.
+    inline f32 uniform(u32 x)
+    {
+        return f32(x >> 8) * (1.f / 16777216.f);
+    }
+
+    /// [0, range) from x without a division.
+    inline u32 scale(u32 x, u32 range)
+    {
+        return u32((u64(x) * range) >> 32);
+    }
+}
@@ -0,0 +1,54 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "PointFrame.hpp"
+
+
+using namespace core;
+
+std::shared_ptr<PointFramePool> PointFramePool::create(u32 capacity)
+{
+    return std::shared_ptr<PointFramePool>(new PointFramePool(capacity));
+}
+
+PointFramePool::PointFramePool(u32 capacity)
+    : _capacity(capacity)
+{
+}
+
+std::shared_ptr<PointFrame::Points> PointFramePool::acquire()
+{
+    std::unique_ptr<PointFrame::Points> points;
+    {
+        std::lock_guard lock(_mutex);
+        if (!_free.empty()) {
+            points = std::move(_free.back());
+            _free.pop_back();
+        }
+    }
+
+    if (!points) {
+        points = std::make_unique<PointFrame::Points>();
+    }
+    points->clear();
+
+    /// frames may outlive the pool; their buffers are then simply freed.
+    return {points.release(), [pool = weak_from_this()](PointFrame::Points* points) {
+        if (auto self = pool.lock()) {
+            self->recycle(points);
+        } else {
+            delete points;
+        }
+    }};
+}
+
+void PointFramePool::recycle(PointFrame::Points* points)
+{
+    std::unique_ptr<PointFrame::Points> owned(points);
+
+    std::lock_guard lock(_mutex);
+    if (_free.size() < _capacity) {
+        _free.push_back(std::move(owned));
+    }
+}
@@ -0,0 +1,78 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <boost/compute/types/fundamental.hpp>
+
+#include <QMetaType>
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// particle positions of one iteration as float2, shared read-only by every thread that
+    /// holds a copy of the frame; copying a frame never copies the points.
+    class PointFrame
+    {
+    public:
+        using Points = std::vector<compute::float2_>;
+
+        PointFrame() = default;
+
+        explicit PointFrame(std::shared_ptr<const Points> points)
+            : _points(std::move(points))
+        {
+        }
+
+        std::span<const compute::float2_> points() const
+        {
+            return _points ? std::span(*_points) : std::span<const compute::float2_>();
+        }
+
+        std::size_t size() const { return _points ? _points->size() : 0; }
+
+        bool isEmpty() const { return size() == 0; }
+
+        auto begin() const { return points().begin(); }
+
+        auto end() const { return points().end(); }
+
+    private:
+        std::shared_ptr<const Points> _points;
+    };
+
+
+    /// recycles the buffers of PointFrames: a buffer returns to the pool when the last frame
+    /// referring to it is destroyed, and is handed out again with its capacity intact.
+    class PointFramePool final : public std::enable_shared_from_this<PointFramePool>
+    {
+    public:
+        /// buffers beyond capacity are freed instead of kept.
+        static std::shared_ptr<PointFramePool> create(u32 capacity = 4);
+
+        /// an empty buffer to fill and wrap in a PointFrame.
+        std::shared_ptr<PointFrame::Points> acquire();
+
+    private:
+        explicit PointFramePool(u32 capacity);
+
+        void recycle(PointFrame::Points* points);
+
+        u32 _capacity;
+        std::mutex _mutex;
+        std::vector<std::unique_ptr<PointFrame::Points>> _free;
+    };
+}
+
+Q_DECLARE_METATYPE(core::PointFrame)
@@ -0,0 +1,113 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "PointSet.hpp"
+
+#include <QSaveFile>
+
+#include <cstring>
+
+
+using namespace core;
+
+namespace
+{
+    struct Header
+    {
+        char magic[8];
+        u32 version;
+        u32 width;
+        u32 height;
+        u32 count;
+        f32 radius;
+        i32 iteration;
+        i32 maxIterations;
+        u32 reserved;
+        u64 seed;
+        u64 image;
+    };
+
+    constexpr char magic[8] = {'E', 'H', 'P', 'O', 'I', 'N', 'T', '\0'};
+
+    static_assert(sizeof(Header) == 56);
+    static_assert(sizeof(Header) % alignof(compute::float2_) == 0);
+}
+
+std::optional<PointSet> PointSet::load(const QString& path)
+{
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header))) {
+        return std::nullopt;
+    }
+
+    const auto* data = file->map(0, file->size());
+    if (data == nullptr) {
+        return std::nullopt;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        file->size() != qint64(sizeof(Header) + std::size_t(header.count) * sizeof(compute::float2_))) {
+        return std::nullopt;
+    }
+
+    PointSet set;
+    set._info.width         = header.width;
+    set._info.height        = header.height;
+    set._info.radius        = header.radius;
+    set._info.iteration     = header.iteration;
+    set._info.maxIterations = header.maxIterations;
+    set._info.seed          = header.seed;
+    set._info.image         = header.image;
+    set._points = std::span(reinterpret_cast<const compute::float2_*>(data + sizeof(Header)), header.count);
+    set._file   = std::move(file);
+    return set;
+}
+
+bool PointSet::store(const QString& path, const PointSetInfo& info, std::span<const compute::float2_> points)
+{
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version       = version;
+    header.width         = info.width;
+    header.height        = info.height;
+    header.count         = u32(points.size());
+    header.radius        = info.radius;
+    header.iteration     = info.iteration;
+    header.maxIterations = info.maxIterations;
+    header.seed          = info.seed;
+    header.image         = info.image;
+
+    /// a run preempted while writing keeps its previous checkpoint.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(points.data()), qint64(points.size_bytes()));
+
+    return file.commit();
+}
+
+u64 PointSet::fingerprint(const std::vector<f32>& values, u32 width, u32 height)
+{
+    /// 64-bit FNV-1a over the dimensions and the values.
+    u64 hash = 0xcbf29ce484222325;
+    auto add = [&hash](const void* data, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 0x100000001b3;
+        }
+    };
+
+    add(&width, sizeof(width));
+    add(&height, sizeof(height));
+    add(values.data(), values.size() * sizeof(f32));
+    return hash;
+}
+
+PointFrame PointSet::frame() const
+{
+    return PointFrame(std::make_shared<const PointFrame::Points>(_points.begin(), _points.end()));
+}
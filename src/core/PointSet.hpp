@@ -0,0 +1,66 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+#include "PointFrame.hpp"
+
+#include <QFile>
+#include <QString>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace core
+{
+    /// what a point set records besides the points, enough to continue the run that made it.
+    struct PointSetInfo
+    {
+        u32 width{0};  ///< of the image.
+        u32 height{0};
+        f32 radius{1};
+        i32 iteration{0};
+        i32 maxIterations{0};
+        u64 seed{0};
+        u64 image{0};  ///< fingerprint of the normalized image, see PointSet::fingerprint.
+    };
+
+
+    /// particle positions of one iteration on disk (*.ehp): a small header followed by the
+    /// positions as float2, so a loaded set is memory-mapped and read without parsing.
+    class PointSet
+    {
+    public:
+        /// bump whenever the layout changes, so older files are rejected.
+        static constexpr u32 version = 1;
+
+        /// maps the point set at path; nullopt if it is missing or not a valid point set.
+        static std::optional<PointSet> load(const QString& path);
+
+        /// writes a point set, replacing the file atomically; returns false on failure.
+        static bool store(const QString& path, const PointSetInfo& info, std::span<const compute::float2_> points);
+
+        /// identifies the image a point set belongs to.
+        static u64 fingerprint(const std::vector<f32>& values, u32 width, u32 height);
+
+        const PointSetInfo& info() const { return _info; }
+
+        /// valid as long as this object lives.
+        std::span<const compute::float2_> points() const { return _points; }
+
+        /// a copy of the points for viewers and exporters.
+        PointFrame frame() const;
+
+    private:
+        PointSet() = default;
+
+        std::unique_ptr<QFile> _file;
+        PointSetInfo _info;
+        std::span<const compute::float2_> _points;
+    };
+}
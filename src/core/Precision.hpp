@@ -0,0 +1,42 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include <string_view>
+
+
+namespace core
+{
+    /// how the force field and push force sums are accumulated; every term is still
+    /// evaluated in float.
+    enum class Precision
+    {
+        Float,  ///< plain float.
+        Mixed,  ///< float with Kahan compensation; close to double at float speed on most devices.
+        Double, ///< double; slow or emulated on many GPUs, and unavailable on some.
+    };
+
+    /// the stages whose precision can be chosen separately.
+    enum class Stage
+    {
+        ForceField,
+        Repulsion,
+    };
+
+    constexpr std::string_view toString(Precision precision)
+    {
+        switch (precision) {
+            case Precision::Float:  return "float";
+            case Precision::Mixed:  return "mixed";
+            case Precision::Double: return "double";
+        }
+        return {};
+    }
+
+    constexpr std::string_view toString(Stage stage)
+    {
+        return stage == Stage::ForceField ? "force field" : "repulsion";
+    }
+}
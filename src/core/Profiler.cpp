@@ -0,0 +1,152 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "Profiler.hpp"
+
+#include <QSaveFile>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <limits>
+
+
+using namespace core;
+
+namespace
+{
+    std::string escaped(std::string_view text)
+    {
+        std::string result;
+        for (const auto c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += c;
+            } else if (u32(uchar(c)) < 0x20) {
+                result += std::format("\\u{:04x}", u32(uchar(c)));
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+}
+
+u32 Profiler::track(const std::string& process, const std::string& thread)
+{
+    std::lock_guard lock(_mutex);
+
+    _tracks.push_back({process, thread});
+    return u32(_tracks.size() - 1);
+}
+
+void Profiler::add(Event event)
+{
+    std::lock_guard lock(_mutex);
+
+    auto& stage    = _stages[event.name];
+    stage.name     = event.name;
+    stage.category = event.category;
+    stage.count++;
+
+    const auto duration = event.ended > event.started ? event.ended - event.started : 0;
+    stage.total  += duration;
+    stage.longest = std::max(stage.longest, duration);
+    stage.waited += event.started > event.queued ? event.started - event.queued : 0;
+
+    if (_events.size() < maxEvents) {
+        _events.push_back(std::move(event));
+    } else {
+        _dropped++;
+    }
+}
+
+std::vector<Profiler::Stage> Profiler::stages() const
+{
+    std::lock_guard lock(_mutex);
+
+    std::vector<Stage> stages;
+    for (const auto& [name, stage] : _stages) {
+        stages.push_back(stage);
+    }
+    std::ranges::sort(stages, std::greater{}, &Stage::total);
+    return stages;
+}
+
+void Profiler::resetStages()
+{
+    std::lock_guard lock(_mutex);
+    _stages.clear();
+}
+
+bool Profiler::writeTrace(const QString& path) const
+{
+    std::lock_guard lock(_mutex);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    /// tracks of the same process share a clock and a pid; every process starts at its first event.
+    std::vector<std::string> processes;
+    std::vector<u32> pids;
+    for (const auto& track : _tracks) {
+        auto found = std::ranges::find(processes, track.process);
+        if (found == processes.end()) {
+            found = processes.insert(processes.end(), track.process);
+        }
+        pids.push_back(u32(found - processes.begin()));
+    }
+
+    auto origins = std::vector<u64>(processes.size(), std::numeric_limits<u64>::max());
+    for (const auto& event : _events) {
+        auto& origin = origins[pids[event.track]];
+        origin = std::min(origin, event.queued);
+    }
+
+    std::string out = "{\"traceEvents\":[\n";
+    auto separator  = "";
+    auto flush = [&] {
+        if (out.size() >= (1 << 16)) {
+            file.write(out.data(), qint64(out.size()));
+            out.clear();
+        }
+    };
+
+    for (std::size_t pid = 0; pid < processes.size(); ++pid) {
+        out += std::format("{}{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":{},\"args\":{{\"name\":\"{}\"}}}}\n",
+                           separator, pid, escaped(processes[pid]));
+        separator = ",";
+    }
+    for (std::size_t tid = 0; tid < _tracks.size(); ++tid) {
+        out += std::format(",{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}\n",
+                           pids[tid], tid, escaped(_tracks[tid].thread));
+    }
+
+    /// microseconds, as the format expects, with the nanoseconds kept as decimals.
+    auto us = [](u64 ns) { return f64(ns) / 1000; };
+
+    for (const auto& event : _events) {
+        const auto origin = origins[pids[event.track]];
+        out += std::format("{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"pid\":{},\"tid\":{},\"ts\":{:.3f},"
+                           "\"dur\":{:.3f},\"args\":{{\"queued\":{:.3f},\"submitted\":{:.3f}}}}}\n",
+                           separator, escaped(event.name), toString(event.category), pids[event.track], event.track,
+                           us(event.started - origin), us(event.ended > event.started ? event.ended - event.started : 0),
+                           us(event.queued - origin), us(event.submitted - origin));
+        separator = ",";
+        flush();
+    }
+
+    out += std::format("],\"displayTimeUnit\":\"ns\",\"otherData\":{{\"droppedEvents\":{}}}}}\n", _dropped);
+    file.write(out.data(), qint64(out.size()));
+
+    return file.commit();
+}
+
+u64 Profiler::now()
+{
+    return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
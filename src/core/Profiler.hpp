@@ -0,0 +1,133 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <QMetaType>
+#include <QString>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace core
+{
+    /// collects timed events of the backends and the host: every kernel and transfer with the
+    /// timestamps of its command, and spans of host work. aggregates them per stage and writes
+    /// them as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+    ///
+    /// shared by any number of backends on any threads. profiling is opt-in: nothing is recorded
+    /// unless a Profiler is handed to ElectrostaticHalftoning::setProfiler.
+    class Profiler
+    {
+    public:
+        enum class Category
+        {
+            Kernel,
+            Transfer,
+            Host,
+        };
+
+        /// one command or span; times in nanoseconds of the clock of its track's process.
+        struct Event
+        {
+            u32 track{0};
+            std::string name;
+            Category category{Category::Host};
+            u64 queued{0};
+            u64 submitted{0};
+            u64 started{0};
+            u64 ended{0};
+        };
+
+        /// what the events of one name add up to since the last resetStages.
+        struct Stage
+        {
+            std::string name;
+            Category category{Category::Host};
+            u64 count{0};
+            u64 total{0};   ///< ns from start to end, summed.
+            u64 longest{0};
+            u64 waited{0};  ///< ns from queued to start, summed; how long commands sat in the queue.
+        };
+
+        /// a row of the trace. events of the tracks of one process share a clock, so a device's
+        /// queues are threads of a process named after the device.
+        u32 track(const std::string& process, const std::string& thread);
+
+        void add(Event event);
+
+        /// the stages by descending total time.
+        std::vector<Stage> stages() const;
+
+        void resetStages();
+
+        /// writes every event kept so far; false if the file cannot be written.
+        bool writeTrace(const QString& path) const;
+
+        /// the host clock host spans are measured with.
+        static u64 now();
+
+        /// times the host work of its lifetime on track; does nothing without a profiler.
+        class Scope
+        {
+        public:
+            Scope(Profiler* profiler, u32 track, const char* name)
+                : _profiler(profiler)
+                , _track(track)
+                , _name(name)
+                , _started(profiler != nullptr ? now() : 0)
+            {
+            }
+
+            ~Scope()
+            {
+                if (_profiler != nullptr) {
+                    _profiler->add({_track, _name, Category::Host, _started, _started, _started, now()});
+                }
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Profiler* _profiler;
+            u32 _track;
+            const char* _name;
+            u64 _started;
+        };
+
+    private:
+        /// events beyond this are only counted in the stages, so a long run cannot exhaust memory.
+        static constexpr std::size_t maxEvents = std::size_t(1) << 21;
+
+        struct Track
+        {
+            std::string process;
+            std::string thread;
+        };
+
+        mutable std::mutex _mutex;
+        std::vector<Track> _tracks;
+        std::vector<Event> _events;
+        std::map<std::string, Stage> _stages;
+        u64 _dropped{0};
+    };
+
+    constexpr std::string_view toString(Profiler::Category category)
+    {
+        switch (category) {
+            case Profiler::Category::Kernel:   return "kernel";
+            case Profiler::Category::Transfer: return "transfer";
+            case Profiler::Category::Host:     return "host";
+        }
+        return "";
+    }
+}
+
+Q_DECLARE_METATYPE(std::vector<core::Profiler::Stage>)
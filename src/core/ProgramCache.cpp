@@ -0,0 +1,123 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "ProgramCache.hpp"
+
+#include <boost/compute/exception/opencl_error.hpp>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <vector>
+
+
+using namespace core;
+
+namespace
+{
+    struct Header
+    {
+        char magic[8];
+        u32 version;
+        u32 reserved;
+        u64 size;
+    };
+
+    constexpr char magic[8] = {'E', 'H', 'P', 'R', 'O', 'G', '\0', '\0'};
+}
+
+ProgramCache::ProgramCache(const QString& directory)
+    : _directory(directory)
+{
+    if (_directory.isEmpty()) {
+        _directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/programs";
+    }
+}
+
+QByteArray ProgramCache::key(const compute::device& device, std::string_view source, std::string_view options)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    auto add = [&](std::string_view text) {
+        /// sizes first, so that no two lists of strings hash alike.
+        const u64 size = text.size();
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(&size), sizeof(size)));
+        hash.addData(QByteArrayView(text.data(), qsizetype(text.size())));
+    };
+
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(&version), sizeof(version)));
+    add(device.platform().name());
+    add(device.platform().version());
+    add(device.vendor());
+    add(device.name());
+    add(device.version());
+    add(device.driver_version());
+    add(options);
+    add(source);
+
+    return hash.result().toHex();
+}
+
+std::optional<compute::program> ProgramCache::load(const QByteArray& key, const compute::context& context,
+                                                   const std::string& options) const
+{
+    QFile file(path(key));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(Header))) {
+        return std::nullopt;
+    }
+
+    const auto data = file.readAll();
+
+    Header header;
+    std::memcpy(&header, data.constData(), sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.size == 0 ||
+        header.size != u64(data.size()) - sizeof(Header)) {
+        return std::nullopt;
+    }
+
+    /// a binary still has to be built, which only links it; drivers reject ones they cannot use.
+    try {
+        auto program = compute::program::create_with_binary(
+            reinterpret_cast<const unsigned char*>(data.constData() + sizeof(Header)), header.size, context);
+        program.build(options);
+        return program;
+    } catch (const compute::opencl_error&) {
+        return std::nullopt;
+    }
+}
+
+bool ProgramCache::store(const QByteArray& key, const compute::program& program) const
+{
+    std::vector<unsigned char> binary;
+    try {
+        binary = program.binary();
+    } catch (const compute::opencl_error&) {
+        return false;
+    }
+    if (binary.empty() || !QDir().mkpath(_directory)) {
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.size    = binary.size();
+
+    QSaveFile file(path(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(binary.data()), qint64(binary.size()));
+
+    return file.commit();
+}
+
+QString ProgramCache::path(const QByteArray& key) const
+{
+    return _directory + '/' + QString::fromLatin1(key) + ".bin";
+}
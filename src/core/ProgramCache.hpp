@@ -0,0 +1,59 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <boost/compute/context.hpp>
+#include <boost/compute/device.hpp>
+#include <boost/compute/program.hpp>
+
+#include <QByteArray>
+#include <QString>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// built OpenCL programs on disk, addressed by everything their binary depends on.
+    ///
+    /// each entry is one file: a small header followed by the binary the driver returned.
+    /// a binary the driver no longer accepts is treated as a miss, so a stale entry only
+    /// costs the source build it would have cost anyway.
+    class ProgramCache
+    {
+    public:
+        /// bump whenever the layout of the entries changes, so older entries are ignored.
+        static constexpr u32 version = 1;
+
+        /// an empty directory means the "programs" directory in the user's cache location.
+        explicit ProgramCache(const QString& directory = {});
+
+        const QString& directory() const { return _directory; }
+
+        /// the key of source built with options for device; it changes with the device, its
+        /// driver and its platform as well.
+        static QByteArray key(const compute::device& device, std::string_view source, std::string_view options);
+
+        /// the program stored under key, built for the device of context, if there is one.
+        std::optional<compute::program> load(const QByteArray& key, const compute::context& context,
+                                             const std::string& options) const;
+
+        /// stores the binary of program under key, replacing the file atomically; returns false
+        /// on failure, or if the driver does not hand out binaries.
+        bool store(const QByteArray& key, const compute::program& program) const;
+
+    private:
+        QString path(const QByteArray& key) const;
+
+        QString _directory;
+    };
+}
@@ -0,0 +1,87 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "QuadTree.hpp"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <ranges>
+
+
+using namespace core;
+
+namespace
+{
+    /// beyond this depth coincident particles are kept in one oversized leaf.
+    constexpr u32 maxDepth = 32;
+}
+
+void QuadTree::build(const std::vector<compute::float2_>& points, u32 leafSize)
+{
+    Q_ASSERT(leafSize > 0);
+
+    _leafSize = leafSize;
+    _points   = points;
+    _nodes.clear();
+    _links.clear();
+
+    if (_points.empty()) {
+        return;
+    }
+
+    auto [minx, maxx] = std::ranges::minmax(_points | std::views::transform([](const auto& p) { return p.x; }));
+    auto [miny, maxy] = std::ranges::minmax(_points | std::views::transform([](const auto& p) { return p.y; }));
+    const auto size = std::max({maxx - minx, maxy - miny, 1.f});
+
+    subdivide(0, _points.size(), minx, miny, size, 0);
+}
+
+void QuadTree::subdivide(u32 begin, u32 end, f32 x, f32 y, f32 size, u32 depth)
+{
+    const auto index = u32(_nodes.size());
+    _nodes.emplace_back();
+    _links.emplace_back();
+
+    f64 cx = 0;
+    f64 cy = 0;
+    for (u32 i = begin; i < end; ++i) {
+        cx += _points[i].x;
+        cy += _points[i].y;
+    }
+    const auto charge = f32(end - begin);
+    _nodes[index] = compute::float4_(cx / charge, cy / charge, charge, size);
+
+    u32 child = 0;
+
+    if (end - begin > _leafSize && depth < maxDepth) {
+        const auto half = size / 2;
+        const auto midx = x + half;
+        const auto midy = y + half;
+
+        /// partition into quadrants: [begin, s1) top-left, [s1, s2) top-right,
+        /// [s2, s3) bottom-left, [s3, end) bottom-right.
+        const auto first = _points.begin() + begin;
+        const auto last  = _points.begin() + end;
+        const auto top   = std::partition(first, last, [midy](const auto& p) { return p.y < midy; });
+        const auto s1    = std::partition(first, top, [midx](const auto& p) { return p.x < midx; });
+        const auto s3    = std::partition(top, last, [midx](const auto& p) { return p.x < midx; });
+
+        const u32 bounds[5] = { begin
+                              , u32(s1 - _points.begin())
+                              , u32(top - _points.begin())
+                              , u32(s3 - _points.begin())
+                              , end };
+        const f32 origins[4][2] = { {x, y}, {midx, y}, {x, midy}, {midx, midy} };
+
+        child = index + 1;
+        for (u32 q = 0; q < 4; ++q) {
+            if (bounds[q] < bounds[q + 1]) {
+                subdivide(bounds[q], bounds[q + 1], origins[q][0], origins[q][1], half, depth + 1);
+            }
+        }
+    }
+
+    _links[index] = compute::uint4_(child, u32(_nodes.size()), begin, end);
+}
@@ -0,0 +1,45 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <boost/compute/types/fundamental.hpp>
+
+#include <vector>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// Barnes-Hut quadtree flattened in depth-first order for stackless traversal.
+    ///
+    /// node i is described by
+    ///   nodes[i] = (centre of charge x, centre of charge y, charge, side length)
+    ///   links[i] = (first child or 0 for a leaf, next node after the subtree, begin, end)
+    /// where [begin, end) is the range of the node's particles in points().
+    class QuadTree
+    {
+    public:
+        void build(const std::vector<compute::float2_>& points, u32 leafSize = 8);
+
+        const std::vector<compute::float4_>& nodes() const { return _nodes; }
+
+        const std::vector<compute::uint4_>& links() const { return _links; }
+
+        /// the input particles reordered so that every node covers a contiguous range.
+        const std::vector<compute::float2_>& points() const { return _points; }
+
+    private:
+        void subdivide(u32 begin, u32 end, f32 x, f32 y, f32 size, u32 depth);
+
+        u32 _leafSize{8};
+        std::vector<compute::float4_> _nodes;
+        std::vector<compute::uint4_> _links;
+        std::vector<compute::float2_> _points;
+    };
+}
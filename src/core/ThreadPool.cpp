@@ -0,0 +1,86 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+
+using namespace core;
+
+ThreadPool::ThreadPool(u32 threads)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (u32 i = 1; i < threads; ++i) {
+        _threads.emplace_back([this](std::stop_token stop) { work(stop); });
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& fn)
+{
+    if (count == 0) {
+        return;
+    }
+
+    struct Job
+    {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    /// a few chunks per thread so that uneven chunks even out.
+    const auto chunkSize = std::max<std::size_t>(1, count / (std::size_t(size()) * 4));
+    const auto chunks    = (count + chunkSize - 1) / chunkSize;
+
+    auto job = std::make_shared<Job>();
+
+    /// helpers that start after every chunk is taken return without touching fn.
+    auto run = [job, &fn, count, chunkSize, chunks] {
+        for (auto chunk = job->next++; chunk < chunks; chunk = job->next++) {
+            const auto begin = chunk * chunkSize;
+            fn(begin, std::min(begin + chunkSize, count));
+            if (++job->done == chunks) {
+                std::lock_guard lock(job->mutex);
+                job->finished.notify_all();
+            }
+        }
+    };
+
+    const auto helpers = std::min<std::size_t>(_threads.size(), chunks - 1);
+    if (helpers > 0) {
+        std::lock_guard lock(_mutex);
+        for (std::size_t i = 0; i < helpers; ++i) {
+            _tasks.emplace_back(run);
+        }
+    }
+    _condition.notify_all();
+
+    run();
+
+    std::unique_lock lock(job->mutex);
+    job->finished.wait(lock, [&job, chunks] { return job->done == chunks; });
+}
+
+void ThreadPool::work(std::stop_token stop)
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(_mutex);
+            if (!_condition.wait(lock, stop, [this] { return !_tasks.empty(); })) {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,45 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace core
+{
+    /// fixed set of worker threads.
+    class ThreadPool
+    {
+    public:
+        /// zero means one thread per hardware thread, counting the caller of parallelFor.
+        explicit ThreadPool(u32 threads = 0);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// number of threads that take part in parallelFor, including the caller.
+        u32 size() const { return u32(_threads.size()) + 1; }
+
+        /// calls fn(begin, end) on disjoint chunks covering [0, count) and returns once all
+        /// chunks are done. the calling thread works on chunks as well, so it is safe to call
+        /// from inside another pool's task.
+        void parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& fn);
+
+    private:
+        void work(std::stop_token stop);
+
+        std::mutex _mutex;
+        std::condition_variable_any _condition;
+        std::deque<std::function<void()>> _tasks;
+        std::vector<std::jthread> _threads;
+    };
+}
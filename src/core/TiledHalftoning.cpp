@@ -0,0 +1,370 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "TiledHalftoning.hpp"
+#include "eh.hpp"
+
+#include <QImage>
+#include <QImageReader>
+#include <QRect>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+
+using namespace core;
+
+namespace
+{
+    /// the HSV value of a pixel, as QColor::valueF computes it for 8-bit channels.
+    inline f32 value(QRgb rgb)
+    {
+        return f32(std::max({qRed(rgb), qGreen(rgb), qBlue(rgb)})) / 255.f;
+    }
+
+    /// the values of an image file, read one rectangle at a time.
+    class Source
+    {
+    public:
+        static std::optional<Source> open(const QString& path)
+        {
+            if (tilingError(path)) {
+                return std::nullopt;
+            }
+
+            QImageReader reader(path);
+            const auto size = reader.size();
+
+            Source source;
+            source._path = path;
+            source._size = size;
+
+            /// formats that cannot decode a part of the image are decoded once, and only their
+            /// values are kept: a quarter of the memory of the decoded image.
+            if (!reader.supportsOption(QImageIOHandler::ClipRect)) {
+                const auto image = reader.read();
+                if (image.size() != size) {
+                    return std::nullopt;
+                }
+                source._plane.resize(std::size_t(size.width()) * size.height());
+                for (i32 row = 0; row < size.height(); ++row) {
+                    auto* line = source._plane.data() + std::size_t(row) * size.width();
+                    for (i32 col = 0; col < size.width(); ++col) {
+                        line[col] = uchar(std::lround(value(image.pixel(col, row)) * 255));
+                    }
+                }
+            }
+
+            return source;
+        }
+
+        QSize size() const { return _size; }
+
+        /// the values of rect, row-major; empty if it cannot be read.
+        std::vector<f32> read(const QRect& rect) const
+        {
+            auto values = std::vector<f32>(std::size_t(rect.width()) * rect.height());
+
+            if (!_plane.empty()) {
+                for (i32 row = 0; row < rect.height(); ++row) {
+                    const auto* line = _plane.data() + std::size_t(rect.y() + row) * _size.width() + rect.x();
+                    std::transform(line, line + rect.width(), values.begin() + std::size_t(row) * rect.width(),
+                                   [](uchar x) { return f32(x) / 255.f; });
+                }
+                return values;
+            }
+
+            QImageReader reader(_path);
+            reader.setClipRect(rect);
+            const auto image = reader.read();
+            if (image.size() != rect.size()) {
+                return {};
+            }
+            for (i32 row = 0; row < rect.height(); ++row) {
+                for (i32 col = 0; col < rect.width(); ++col) {
+                    values[std::size_t(row) * rect.width() + col] = value(image.pixel(col, row));
+                }
+            }
+            return values;
+        }
+
+    private:
+        Source() = default;
+
+        QString _path;
+        QSize _size;
+        std::vector<uchar> _plane; ///< the whole image if it is not streamed.
+    };
+
+    /// the mean distance to the nearest other point of the points within one mean spacing of an
+    /// edge between tiles, and of the others. the points are bucketed in a grid of that spacing.
+    std::pair<f32, f32> spacings(const PointFrame::Points& points, const QSize& size, i32 side)
+    {
+        if (points.size() < 2) {
+            return {0, 0};
+        }
+
+        const auto cell    = f32(std::sqrt(f64(size.width()) * size.height() / f64(points.size())));
+        const auto columns = i32(f32(size.width()) / cell) + 1;
+        const auto rows    = i32(f32(size.height()) / cell) + 1;
+        auto cellOf = [&](const compute::float2_& p) {
+            return std::pair(std::clamp(i32(p.x / cell), 0, columns - 1), std::clamp(i32(p.y / cell), 0, rows - 1));
+        };
+
+        /// the points sorted by cell, and where every cell starts.
+        auto starts = std::vector<u32>(std::size_t(columns) * rows + 1);
+        for (const auto& p : points) {
+            const auto [col, row] = cellOf(p);
+            starts[std::size_t(row) * columns + col + 1]++;
+        }
+        std::partial_sum(starts.begin(), starts.end(), starts.begin());
+        auto order = std::vector<u32>(points.size());
+        auto fill  = std::vector<u32>(starts.begin(), starts.end() - 1);
+        for (u32 i = 0; i < points.size(); ++i) {
+            const auto [col, row] = cellOf(points[i]);
+            order[fill[std::size_t(row) * columns + col]++] = i;
+        }
+
+        /// cells r rings away are at least (r-1) cells away, so the search stops once the nearest
+        /// point found is closer than the ring just searched.
+        auto nearest = [&](u32 i) {
+            const auto& p = points[i];
+            const auto [col, row] = cellOf(p);
+            auto best = std::numeric_limits<f32>::max();
+            for (i32 ring = 0; ring <= std::max(columns, rows); ++ring) {
+                for (i32 r = std::max(row - ring, 0); r <= std::min(row + ring, rows - 1); ++r) {
+                    for (i32 c = std::max(col - ring, 0); c <= std::min(col + ring, columns - 1); ++c) {
+                        if (std::max(std::abs(r - row), std::abs(c - col)) != ring) {
+                            continue;
+                        }
+                        const auto index = std::size_t(r) * columns + c;
+                        for (auto k = starts[index]; k < starts[index + 1]; ++k) {
+                            if (order[k] != i) {
+                                const auto dx = points[order[k]].x - p.x;
+                                const auto dy = points[order[k]].y - p.y;
+                                best = std::min(best, dx * dx + dy * dy);
+                            }
+                        }
+                    }
+                }
+                if (best < std::numeric_limits<f32>::max() && std::sqrt(best) <= f32(ring) * cell) {
+                    break;
+                }
+            }
+            return std::sqrt(best);
+        };
+
+        /// the distance to the nearest edge between two tiles along one axis.
+        auto seamDistance = [side](f32 x, i32 extent) {
+            const auto edge = i32(std::lround(x / f32(side))) * side;
+            return edge > 0 && edge < extent ? std::abs(x - f32(edge)) : std::numeric_limits<f32>::max();
+        };
+
+        f64 seam = 0;
+        f64 interior = 0;
+        u64 seamCount = 0;
+        for (u32 i = 0; i < points.size(); ++i) {
+            const auto& p = points[i];
+            const auto distance = nearest(i);
+            if (std::min(seamDistance(p.x, size.width()), seamDistance(p.y, size.height())) < cell) {
+                seam += distance;
+                seamCount++;
+            } else {
+                interior += distance;
+            }
+        }
+
+        const auto interiorCount = points.size() - seamCount;
+        return {seamCount > 0 ? f32(seam / f64(seamCount)) : 0.f,
+                interiorCount > 0 ? f32(interior / f64(interiorCount)) : 0.f};
+    }
+
+    /// the tile size actually used: tile and halo on both sides are kept within a power of two,
+    /// which the FFT force field pads to twice its size instead of four times.
+    i32 tileSide(const Tiling& tiling)
+    {
+        const auto region = std::bit_floor(tiling.tileSize + 2 * tiling.halo);
+        return region > 2 * tiling.halo ? i32(region - 2 * tiling.halo) : i32(tiling.tileSize);
+    }
+
+    /// what halftoneTiled changes on eh, put back however it returns.
+    struct Saved
+    {
+        explicit Saved(ElectrostaticHalftoning& eh)
+            : eh(eh)
+            , seed(eh.seed())
+            , cache(eh.forceFieldCache())
+        {
+        }
+
+        ~Saved()
+        {
+            eh.setSeed(seed);
+            eh.setForceFieldCache(cache);
+            eh.setFixedParticles({});
+        }
+
+        ElectrostaticHalftoning& eh;
+        u64 seed;
+        std::shared_ptr<const ForceFieldCache> cache;
+    };
+
+    /// the first tile keeps the seed, so an image that fits in one tile halftones as it would
+    /// untiled.
+    u64 tileSeed(u64 seed, u32 tile)
+    {
+        return seed + 0x9E3779B97F4A7C15ull * tile;
+    }
+}
+
+std::optional<std::string> core::tilingError(const QString& path)
+{
+    QImageReader reader(path);
+    const auto size = reader.size();
+    if (!reader.canRead() || size.isEmpty()) {
+        return "cannot read image";
+    }
+    const auto pixels = u64(size.width()) * u64(size.height());
+    if (!reader.supportsOption(QImageIOHandler::ClipRect) && pixels > maxDecodedPixels) {
+        return std::format("a {}x{} {} image would have to be decoded whole, as its format cannot decode a part of "
+                           "it; the limit is {} megapixels, convert it to e.g. JPEG", size.width(), size.height(),
+                           reader.format().toStdString(), maxDecodedPixels >> 20);
+    }
+    return std::nullopt;
+}
+
+std::optional<TiledResult> core::halftoneTiled(ElectrostaticHalftoning& eh, const QString& path, i32 particleCount,
+                                               const Tiling& tiling,
+                                               const std::function<void(u32 tile, u32 tiles)>& progress)
+{
+    Q_ASSERT(tiling.tileSize > 0);
+
+    const auto source = Source::open(path);
+    if (!source) {
+        return std::nullopt;
+    }
+
+    const auto size    = source->size();
+    const auto bounds  = QRect(QPoint(0, 0), size);
+    const auto side    = tileSide(tiling);
+    const auto halo    = i32(tiling.halo);
+    const auto columns = (size.width() + side - 1) / side;
+    const auto tiles   = u32(columns * ((size.height() + side - 1) / side));
+
+    auto tileRect = [&](u32 tile) {
+        return QRect(i32(tile) % columns * side, i32(tile) / columns * side, side, side) & bounds;
+    };
+
+    /// the image is normalized as a whole like normalizedValues does, and the particles are shared
+    /// out by darkness, so its range and total are needed before the first tile runs.
+    f32 minv = 1;
+    f32 maxv = 0;
+    f64 sum  = 0;
+    for (u32 tile = 0; tile < tiles; ++tile) {
+        const auto values = source->read(tileRect(tile));
+        if (values.empty()) {
+            return std::nullopt;
+        }
+        const auto [lo, hi] = std::ranges::minmax(values);
+        minv = std::min(minv, lo);
+        maxv = std::max(maxv, hi);
+        for (auto x : values) { sum += x; }
+    }
+
+    const auto range  = maxv - minv;
+    const auto pixels = f64(size.width()) * size.height();
+    const auto totalDarkness = range > 0 ? (pixels * maxv - sum) / range : pixels - sum;
+
+    auto points = std::make_shared<PointFrame::Points>();
+    TiledResult result{{}, size};
+
+    /// a tile's field is of no use to any other image, so it is not cached.
+    const Saved saved(eh);
+    eh.setForceFieldCache(nullptr);
+
+    /// where the points of every finished tile start in points; the last entry is its size.
+    auto starts = std::vector<std::size_t>{0};
+
+    for (u32 tile = 0; tile < tiles; ++tile) {
+        const auto own    = tileRect(tile);
+        const auto region = own.adjusted(-halo, -halo, halo, halo) & bounds;
+
+        auto values = source->read(region);
+        if (values.empty()) {
+            return std::nullopt;
+        }
+
+        /// the tiles are finished in raster order, so the halo's pixels of a lower index are
+        /// already covered by points, which stay where they are and push this tile's particles
+        /// like any other. only the darkness of the other pixels is left to this tile.
+        auto finished = [&](i32 x, i32 y) { return u32(y / side * columns + x / side) < tile; };
+
+        f64 darkness = 0;
+        for (i32 row = 0; row < region.height(); ++row) {
+            for (i32 col = 0; col < region.width(); ++col) {
+                auto& x = values[std::size_t(row) * region.width() + col];
+                if (range > 0) {
+                    x = std::clamp((x - minv) / range, 0.f, 1.f);
+                }
+                if (!finished(region.x() + col, region.y() + row)) {
+                    darkness += 1 - x;
+                }
+            }
+        }
+
+        const auto left = f32(region.x());
+        const auto top  = f32(region.y());
+
+        std::vector<compute::float2_> fixed;
+        for (u32 other = 0; other < tile; ++other) {
+            if (!tileRect(other).intersects(region)) {
+                continue;
+            }
+            for (auto i = starts[other]; i < starts[other + 1]; ++i) {
+                const auto& p = (*points)[i];
+                if (p.x >= left && p.x < left + f32(region.width()) &&
+                    p.y >= top  && p.y < top  + f32(region.height())) {
+                    fixed.emplace_back(p.x - left, p.y - top);
+                }
+            }
+        }
+
+        const auto count = totalDarkness > 0 ? i32(std::lround(particleCount * darkness / totalDarkness)) : 0;
+        if (count > 0) {
+            eh.setSeed(tileSeed(saved.seed, tile));
+            eh.setParticleCount(count);
+            eh.setFixedParticles(std::move(fixed));
+            eh.setValues(values, region.width(), region.height());
+            eh.run();
+
+            /// points in the halo belong to the neighbouring tiles, which keep their own.
+            for (const auto& p : eh.points()) {
+                const auto x = p.x + left;
+                const auto y = p.y + top;
+                if (x >= own.left() && x < own.left() + own.width() &&
+                    y >= own.top()  && y < own.top()  + own.height()) {
+                    points->emplace_back(x, y);
+                }
+            }
+
+            result.tiles++;
+            result.iterations = std::max(result.iterations, eh.currentIteration());
+        }
+
+        starts.push_back(points->size());
+
+        if (progress) {
+            progress(tile + 1, tiles);
+        }
+    }
+
+    std::tie(result.seamSpacing, result.interiorSpacing) = spacings(*points, size, side);
+    result.points = PointFrame(std::move(points));
+    return result;
+}
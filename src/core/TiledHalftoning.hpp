@@ -0,0 +1,68 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+#include "PointFrame.hpp"
+
+#include <QSize>
+#include <QString>
+
+#include <functional>
+#include <optional>
+#include <string>
+
+
+namespace core
+{
+    class ElectrostaticHalftoning;
+
+    /// how an image is split by halftoneTiled.
+    struct Tiling
+    {
+        /// side of the part of the image whose points a tile keeps; lowered so that it and the halo
+        /// on both sides fit in a power of two, e.g. 2048 with a halo of 128 runs 1792-pixel tiles.
+        u32 tileSize{1792};
+        u32 halo{128};      ///< pixels simulated around it on every side and then dropped.
+    };
+
+    struct TiledResult
+    {
+        PointFrame points; ///< in the pixels of the whole image.
+        QSize size;        ///< of the whole image.
+        u32 tiles{0};      ///< tiles that had particles.
+        i32 iterations{0}; ///< the most any tile ran.
+        f32 seamSpacing{0};     ///< mean nearest-neighbour distance within one spacing of a tile edge.
+        f32 interiorSpacing{0}; ///< the same for the other points; seamSpacing matches it without seams.
+    };
+
+    /// the most pixels of an image halftoneTiled accepts in a format that cannot decode a part of
+    /// it, e.g. PNG: such an image is decoded whole once, at up to 4 bytes a pixel, about 1 GiB.
+    inline constexpr u64 maxDecodedPixels = u64(1) << 28;
+
+    /// why halftoneTiled cannot read the image at path, or nullopt if it can.
+    std::optional<std::string> tilingError(const QString& path);
+
+    /// halftones the image at path one tile at a time, so that neither the force field nor the
+    /// particles of the whole image have to fit on the device at once.
+    ///
+    /// every tile runs eh on its pixels and a halo around them and keeps the points that end up
+    /// inside the tile. the tiles run in raster order: the points already kept by the finished
+    /// neighbours in the halo are fixed particles that push the tile's own, and the tile gets a
+    /// share of particleCount proportional to the darkness of the rest of its region. the halo
+    /// supplies the charges of the neighbouring tiles, so the tiles meet without visible seams
+    /// once it is a few dot spacings wide. the image is normalized as a whole, and each tile's
+    /// seed is derived from eh's, so the result is reproducible.
+    ///
+    /// the tiles are read from the file one at a time if its format can decode a part of the
+    /// image; otherwise it is decoded once and kept as 8-bit values, which is refused above
+    /// maxDecodedPixels. eh is configured by the
+    /// caller except for its particle count, seed, values and fixed particles; its seed is
+    /// restored afterwards, and its force field cache is left unused while the tiles run. progress,
+    /// if set, is called after every tile. nullopt if the image cannot be read.
+    std::optional<TiledResult> halftoneTiled(ElectrostaticHalftoning& eh, const QString& path, i32 particleCount,
+                                             const Tiling& tiling = {},
+                                             const std::function<void(u32 tile, u32 tiles)>& progress = {});
+}
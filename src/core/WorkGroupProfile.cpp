@@ -0,0 +1,102 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "WorkGroupProfile.hpp"
+
+#include <boost/compute/platform.hpp>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <sstream>
+
+
+using namespace core;
+
+namespace
+{
+    constexpr std::string_view magic = "# electrostatic halftoning work-group profile";
+}
+
+WorkGroupProfile::WorkGroupProfile(const compute::device& device, const QString& directory)
+    : _device(device.name() + ", " + device.driver_version() + ", " + device.platform().name())
+{
+    auto dir = directory;
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/workgroups";
+    }
+
+    /// timings only hold for the device and the driver they were taken with.
+    const auto identity = _device + ", " + device.vendor();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArrayView(identity.data(), qsizetype(identity.size())));
+    _path = dir + '/' + QString::fromLatin1(hash.result().toHex().left(32)) + ".txt";
+
+    QFile file(_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    /// one "kernel precision bucket local perItem" line per setting, after the header line.
+    std::istringstream lines(file.readAll().toStdString());
+    std::string line;
+    if (!std::getline(lines, line) || line != std::string(magic) + " " + std::to_string(version)) {
+        return;
+    }
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string kernel;
+        std::string precision;
+        u32 bucket = 0;
+        Setting setting;
+        if (line.starts_with('#') || !(fields >> kernel >> precision >> bucket >> setting.local >> setting.perItem)) {
+            continue;
+        }
+        _settings[kernel + ' ' + precision + ' ' + std::to_string(bucket)] = setting;
+    }
+}
+
+std::optional<WorkGroupProfile::Setting> WorkGroupProfile::find(std::string_view kernel, Precision precision,
+                                                                std::size_t items) const
+{
+    std::lock_guard lock(_mutex);
+
+    if (const auto found = _settings.find(key(kernel, precision, bucket(items))); found != _settings.end()) {
+        return found->second;
+    }
+    return std::nullopt;
+}
+
+bool WorkGroupProfile::store(std::string_view kernel, Precision precision, std::size_t items, const Setting& setting)
+{
+    std::lock_guard lock(_mutex);
+
+    _settings[key(kernel, precision, bucket(items))] = setting;
+
+    if (!QDir().mkpath(QFileInfo(_path).absolutePath())) {
+        return false;
+    }
+
+    std::string text = std::string(magic) + " " + std::to_string(version) + "\n# " + _device + "\n";
+    for (const auto& [name, stored] : _settings) {
+        text += name + ' ' + std::to_string(stored.local) + ' ' + std::to_string(stored.perItem) + '\n';
+    }
+
+    QSaveFile file(_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(text.data(), qint64(text.size()));
+
+    return file.commit();
+}
+
+std::string WorkGroupProfile::key(std::string_view kernel, Precision precision, u32 bucket)
+{
+    return std::string(kernel) + ' ' + std::string(toString(precision)) + ' ' + std::to_string(bucket);
+}
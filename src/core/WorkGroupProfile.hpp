@@ -0,0 +1,70 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "types.hpp"
+#include "Precision.hpp"
+
+#include <boost/compute/device.hpp>
+
+#include <QString>
+
+#include <bit>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+namespace compute = boost::compute;
+
+
+namespace core
+{
+    /// the work-group sizes the kernels of kernels.cl run fastest with on one device, found by
+    /// timing candidates on it (see OpenClBackend) and kept in a small text file per device and
+    /// driver, so that later runs start with them.
+    ///
+    /// settings are per kernel, precision and problem size bucket: work-item counts within a
+    /// factor of two of each other share one.
+    class WorkGroupProfile
+    {
+    public:
+        /// bump whenever the kernels change in a way that makes older timings meaningless.
+        static constexpr u32 version = 1;
+
+        struct Setting
+        {
+            u32 local{0};   ///< work-group size; 0 leaves it to the driver.
+            u32 perItem{1}; ///< particles per work-item, of the kernels that take several.
+        };
+
+        /// reads the profile of device from directory; an empty directory means the
+        /// "workgroups" directory in the user's cache location.
+        explicit WorkGroupProfile(const compute::device& device, const QString& directory = {});
+
+        WorkGroupProfile(const WorkGroupProfile&) = delete;
+        WorkGroupProfile& operator=(const WorkGroupProfile&) = delete;
+
+        const QString& path() const { return _path; }
+
+        static u32 bucket(std::size_t items) { return u32(std::bit_width(items)); }
+
+        std::optional<Setting> find(std::string_view kernel, Precision precision, std::size_t items) const;
+
+        /// records setting and rewrites the file atomically; returns false if it cannot be written.
+        bool store(std::string_view kernel, Precision precision, std::size_t items, const Setting& setting);
+
+    private:
+        static std::string key(std::string_view kernel, Precision precision, u32 bucket);
+
+        QString _path;
+        std::string _device; ///< written as a comment, for whoever reads the file.
+
+        mutable std::mutex _mutex;
+        std::map<std::string, Setting> _settings;
+    };
+}
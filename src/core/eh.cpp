@@ -3,18 +3,21 @@
 
 
 #include "eh.hpp"
+#include "MultiDeviceBackend.hpp"
+#include "NativeBackend.hpp"
+#include "OpenClBackend.hpp"
 
 #include <QImage>
+#include <QMetaMethod>
 
-#include <boost/compute/algorithm/copy.hpp>
 #include <boost/compute/system.hpp>
-#include <boost/compute/types/fundamental.hpp>
-#include <boost/compute/utility/source.hpp>
 
+#include <cmath>
 #include <concepts>
+#include <exception>
 #include <print>
-#include <random>
 #include <ranges>
+#include <utility>
 
 
 using namespace core;
@@ -27,9 +30,95 @@ namespace
         return row * width + col;
     }
 
+    /// Auto as overridden by EH_BACKEND.
+    BackendType resolved(BackendType type)
+    {
+        if (type == BackendType::Auto) {
+            if (const auto name = qEnvironmentVariable("EH_BACKEND").toLower(); name == "native") {
+                return BackendType::Native;
+            } else if (name == "opencl") {
+                return BackendType::OpenCL;
+            } else if (name == "all") {
+                return BackendType::AllDevices;
+            }
+        }
+        return type;
+    }
+}
+
+std::shared_ptr<Device> core::selectDevice(BackendType type)
+{
+    type = resolved(type);
+    if (type == BackendType::AllDevices) {
+        type = BackendType::OpenCL;
+    }
+
+    if (type != BackendType::Native) {
+        try {
+            auto device = compute::system::default_device();
+            if (type == BackendType::OpenCL || device.type() == CL_DEVICE_TYPE_GPU) {
+                return std::make_shared<Device>(device);
+            }
+        } catch (const std::exception& e) {
+            if (type == BackendType::OpenCL) {
+                throw;
+            }
+            std::println("OpenCL unavailable: {}", e.what());
+        }
+    }
 
-    const char cl_source[] =
-    #include "kernels.cl"
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<Device>> core::allDevices()
+{
+    std::vector<std::shared_ptr<Device>> devices;
+    for (const auto& platform : compute::system::platforms()) {
+        for (const auto& device : platform.devices()) {
+            std::vector<compute::device> parts;
+            if (device.type() & CL_DEVICE_TYPE_CPU) {
+                try {
+                    parts = device.partition_by_affinity_domain(CL_DEVICE_AFFINITY_DOMAIN_NUMA);
+                } catch (const std::exception&) {
+                    /// fission or NUMA partitioning is not supported; the device stays whole.
+                }
+            }
+            if (parts.size() < 2) {
+                parts = {device};
+            }
+            for (const auto& part : parts) {
+                devices.push_back(std::make_shared<Device>(part));
+            }
+        }
+    }
+    return devices;
+}
+
+std::vector<std::shared_ptr<Device>> core::selectDevices(BackendType type)
+{
+    if (resolved(type) == BackendType::AllDevices) {
+        return allDevices();
+    }
+    if (auto device = selectDevice(type)) {
+        return {device};
+    }
+    return {};
+}
+
+std::unique_ptr<Backend> core::createBackend(const std::shared_ptr<Device>& device, u32 threads)
+{
+    if (device) {
+        return std::make_unique<OpenClBackend>(device);
+    }
+    return std::make_unique<NativeBackend>(threads);
+}
+
+std::unique_ptr<Backend> core::createBackend(const std::vector<std::shared_ptr<Device>>& devices, u32 threads)
+{
+    if (devices.size() > 1) {
+        return std::make_unique<MultiDeviceBackend>(devices);
+    }
+    return createBackend(devices.empty() ? nullptr : devices.front(), threads);
 }
 
 std::vector<f32> core::normalizedValues(const QImage& image)
@@ -64,30 +153,31 @@ std::vector<f32> core::normalizedValues(const QImage& image)
 }
 
 ElectrostaticHalftoning::ElectrostaticHalftoning(QObject* parent)
-    : QObject(parent)
+    : ElectrostaticHalftoning(BackendType::Auto, parent)
 {
-    auto device = compute::system::default_device();
+}
 
-    if (device.type() == CL_DEVICE_TYPE_GPU) {
-        std::println("\ngpu: {}", device.name());
-        std::println("driver: {}", device.driver_version());
-        std::println("platform: {}", device.platform().name());
-        std::println("{}", device.platform().version());
-        std::println("compute units: {}", device.compute_units());
+ElectrostaticHalftoning::ElectrostaticHalftoning(BackendType type, QObject* parent)
+    : ElectrostaticHalftoning(createBackend(selectDevices(type)), parent)
+{
+    std::println("backend: {}", _backend->name());
+    std::println("precision: {} force field, {} repulsion", toString(precision(Stage::ForceField)),
+                 toString(precision(Stage::Repulsion)));
+}
 
-        _context = compute::context(device);
-        _queue   = compute::command_queue(_context, device);
-        _program = compute::program::create_with_source(cl_source, _context);
-        _program.build();
+ElectrostaticHalftoning::ElectrostaticHalftoning(std::unique_ptr<Backend> backend, QObject* parent)
+    : QObject(parent)
+    , _backend(std::move(backend))
+{
+    Q_ASSERT(_backend);
 
-        _values_dev   = compute::vector<f32>(1, _context);
-        _forceField   = compute::vector<compute::float2_>(1, _context);
-        _particles_k0 = compute::vector<compute::float2_>(1, _context);
-        _particles_k1 = compute::vector<compute::float2_>(1, _context);
-        _shake        = compute::vector<compute::float2_>(1, _context);
+    for (auto stage : {Stage::ForceField, Stage::Repulsion}) {
+        _precision[std::size_t(stage)] = _backend->setPrecision(stage, _precision[std::size_t(stage)]);
     }
 }
 
+ElectrostaticHalftoning::~ElectrostaticHalftoning() = default;
+
 void ElectrostaticHalftoning::setValues(const std::vector<f32>& values, u32 width, u32 height)
 {
     Q_ASSERT(values.size() == width * height);
@@ -96,9 +186,13 @@ void ElectrostaticHalftoning::setValues(const std::vector<f32>& values, u32 widt
     _width  = width;
     _height = height;
     _values = values;
+    _fingerprint = PointSet::fingerprint(_values, _width, _height);
 
-    _values_dev.resize(_values.size());
-    compute::copy(_values.begin(), _values.end(), _values_dev.begin(), _queue);
+    /// particles are placed with a probability proportional to the darkness of their pixel.
+    auto darkness = std::vector<f32>(_values.size());
+    std::ranges::transform(_values, darkness.begin(), [](auto x) { return 1.f - x; });
+    _density.build(darkness);
+    _backend->setDensity(_density, _width);
 
     computeForceField();
     reset();
@@ -118,15 +212,94 @@ void ElectrostaticHalftoning::setParticleRadius(f32 radius)
     }
 }
 
+void ElectrostaticHalftoning::setSeed(u64 seed)
+{
+    if (seed != _seed) {
+        _seed = seed;
+        reset();
+    }
+}
+
 void ElectrostaticHalftoning::setMaxIteration(i32 i)
 {
     _maxIterations = std::max(1, i);
     reset();
 }
 
+void ElectrostaticHalftoning::setForceFieldMethod(ForceFieldMethod method)
+{
+    if (std::exchange(_forceFieldMethod, method) != method && !_values.empty()) {
+        computeForceField();
+        reset();
+    }
+}
+
+void ElectrostaticHalftoning::setForceFieldCache(std::shared_ptr<const ForceFieldCache> cache)
+{
+    _forceFieldCache = std::move(cache);
+}
+
+void ElectrostaticHalftoning::setFixedParticles(std::vector<compute::float2_> points)
+{
+    _fixedParticles = std::move(points);
+}
+
+void ElectrostaticHalftoning::setPrecision(Stage stage, Precision precision)
+{
+    const auto used = _backend->setPrecision(stage, precision);
+    if (used != precision) {
+        std::println("{} precision: {} is unavailable on {}, using {}", toString(stage), toString(precision),
+                     _backend->name(), toString(used));
+    }
+
+    if (std::exchange(_precision[std::size_t(stage)], used) != used && stage == Stage::ForceField
+        && _forceFieldMethod == ForceFieldMethod::Direct && !_values.empty()) {
+        computeForceField();
+        reset();
+    }
+}
+
+void ElectrostaticHalftoning::setRepulsion(Repulsion method)
+{
+    if (method != _repulsion) {
+        _repulsion = method;
+        reset();
+    }
+}
+
+void ElectrostaticHalftoning::setOpeningAngle(f32 theta)
+{
+    _theta = std::max(0.f, theta);
+}
+
+void ElectrostaticHalftoning::setTiling(u32 tileSize, u32 particlesPerItem)
+{
+    _tileSize         = std::max(1u, tileSize);
+    _particlesPerItem = std::clamp(particlesPerItem, 1u, 4u);
+}
+
+void ElectrostaticHalftoning::setTolerance(f32 tolerance)
+{
+    _tolerance = std::max(0.f, tolerance);
+}
+
+void ElectrostaticHalftoning::setProfiler(std::shared_ptr<Profiler> profiler)
+{
+    _profiler = profiler;
+    if (_profiler) {
+        _profilerTrack = _profiler->track("host", "halftoning");
+    }
+    _backend->setProfiler(std::move(profiler));
+}
+
+void ElectrostaticHalftoning::setReadbackInterval(i32 interval)
+{
+    _readbackInterval = std::max(0, interval);
+}
+
 void ElectrostaticHalftoning::nextIteration()
 {
-    if (_currentIteration >= _maxIterations) {
+    if (finished()) {
         return;
     }
     _currentIteration++;
@@ -135,129 +308,263 @@ void ElectrostaticHalftoning::nextIteration()
         shake();
     }
 
-    compute::float2_ boundry{_width - 1.f , _height - 1.f };
+    const Step step{{_width - 1.f , _height - 1.f }, _radius};
+
+    switch (_repulsion) {
+        case Repulsion::Exact:
+            _backend->iterateExact(step);
+            break;
+        case Repulsion::Tiled:
+            _backend->iterateTiled(step, _tileSize, _particlesPerItem);
+            break;
+        case Repulsion::BarnesHut:
+            /// the tree is rebuilt on the host from the current positions every iteration.
+            _backend->particles(_hostParticles);
+            {
+                const Profiler::Scope scope(_profiler.get(), _profilerTrack, "build quadtree");
+                _quadTree.build(_hostParticles);
+            }
+            _backend->iterateBarnesHut(step, _quadTree, _theta);
+            break;
+        case Repulsion::P3M:
+            _backend->particles(_hostParticles);
+            {
+                const Profiler::Scope scope(_profiler.get(), _profilerTrack, "build mesh");
+                _particleMesh.build(_hostParticles, _width, _height);
+            }
+            _backend->iterateParticleMesh(step, _particleMesh);
+            break;
+    }
 
-    _iterateKernel = _program.create_kernel("iterate");
-    _iterateKernel.set_arg(0, _particles_k0.get_buffer());
-    _iterateKernel.set_arg(1, _particles_k1.get_buffer());
-    _iterateKernel.set_arg(2, _forceField.get_buffer());
-    _iterateKernel.set_arg(3, _width);
-    _iterateKernel.set_arg(4, boundry);
-    _iterateKernel.set_arg(5, _radius);
+    /// like readbacks, measurements are taken one iteration late so that the device always
+    /// has this iteration queued while the host waits.
+    const auto measure = _tolerance > 0 ||
+                         isSignalConnected(QMetaMethod::fromSignal(&ElectrostaticHalftoning::convergenceMeasured));
+    if (measure) {
+        _backend->beginMeasure();
+        _pendingMeasures.push_back(_currentIteration);
+    }
+    while (_pendingMeasures.size() > 1 || (finished() && !_pendingMeasures.empty())) {
+        takeMeasure();
+    }
 
-    _queue.enqueue_1d_range_kernel(_iterateKernel, 0, _particles_k0.size(), 0).wait();
-    _queue.finish();
+    const auto last = finished();
 
-    updateResult();
-    _particles_k0.swap(_particles_k1);
+    const auto readback = last || (_readbackInterval > 0 && _currentIteration % _readbackInterval == 0);
+    if (readback) {
+        _backend->beginReadback();
+        _pendingReadbacks.push_back(_currentIteration);
+    }
 
-    emit iterationFinished(_results, _currentIteration, _maxIterations);
+    /// the previous readback is emitted while this iteration computes; the last one is
+    /// emitted right away, and a run that converged early reports itself as complete.
+    const auto keep    = last ? 0u : 1u;
+    const auto iterMax = _converged ? _currentIteration : _maxIterations;
+    while (_pendingReadbacks.size() > keep) {
+        updateResult();
+        emit iterationFinished(_frame, _pendingReadbacks.front(), iterMax);
+        _pendingReadbacks.pop_front();
+    }
+
+    if (_checkpointInterval > 0 && (last || _currentIteration % _checkpointInterval == 0) &&
+        !checkpoint(_checkpointPath)) {
+        std::println("cannot write the checkpoint {}", _checkpointPath.toStdString());
+    }
 }
 
-void ElectrostaticHalftoning::updateResult()
+bool ElectrostaticHalftoning::checkpoint(const QString& path)
 {
-    struct Pusher
-    {
-        using value_type = std::vector<compute::float2_>::value_type;
+    _backend->particles(_hostParticles);
 
-        Pusher(QVector<QPointF>& destination) : _d(&destination) { }
+    const PointSetInfo info{_width, _height, _radius, _currentIteration, _maxIterations, _seed, _fingerprint};
+    return PointSet::store(path, info, _hostParticles);
+}
 
-        void push_back(const value_type& value) const
-        {
-            _d->push_back(QPointF(value.x, value.y));
-        }
-        QVector<QPointF>* _d;
-    };
+void ElectrostaticHalftoning::setCheckpoint(const QString& path, i32 interval)
+{
+    _checkpointPath     = path;
+    _checkpointInterval = path.isEmpty() ? 0 : std::max(0, interval);
+}
 
-    _results.clear();
-    _results.resize(_particles_k0.size());
+bool ElectrostaticHalftoning::resume(const PointSet& set)
+{
+    const auto& info = set.info();
+    if (_values.empty() || info.width != _width || info.height != _height || info.image != _fingerprint ||
+        set.points().empty()) {
+        return false;
+    }
 
-    auto pusher = Pusher(_results);
+    drain();
+    _converged        = false;
+    _particleCount    = i32(set.points().size());
+    _radius           = info.radius;
+    _seed             = info.seed;
+    _maxIterations    = std::max(1, info.maxIterations);
+    _currentIteration = std::clamp(info.iteration, 0, _maxIterations);
+
+    _hostParticles.assign(set.points().begin(), set.points().end());
+    _backend->setParticles(_hostParticles);
+    _frame = set.frame();
+    return true;
+}
 
-    compute::copy(_particles_k0.begin(), _particles_k0.end(), std::back_inserter(pusher), _queue);
+void ElectrostaticHalftoning::run()
+{
+    while (!finished()) {
+        nextIteration();
+    }
 }
 
-void ElectrostaticHalftoning::computeForceField()
+void ElectrostaticHalftoning::takeMeasure()
 {
-    _forceField.resize((_width + 2) * (_height + 2));
-    compute::fill(_forceField.begin(), _forceField.end(), compute::float2_(0, 0), _queue);
+    const auto convergence = _backend->finishMeasure();
+    const auto iteration   = _pendingMeasures.front();
+    _pendingMeasures.pop_front();
 
-    _forceFieldKernel = _program.create_kernel("computeForceField");
-    _forceFieldKernel.set_arg(0, _values_dev.get_buffer());
-    _forceFieldKernel.set_arg(1, _forceField.get_buffer());
-    _forceFieldKernel.set_arg(2, _width);
-    _forceFieldKernel.set_arg(3, _height);
-    _queue.enqueue_1d_range_kernel(_forceFieldKernel, 0, _width*_height, 0).wait();
-    _queue.finish();
+    emit convergenceMeasured(convergence, iteration);
 
-    emit forceFieldGenerated();
+    if (_tolerance > 0 && convergence.maxDisplacement < _tolerance) {
+        _converged = true;
+    }
 }
 
-void ElectrostaticHalftoning::initializeParticles(i32 count)
+void ElectrostaticHalftoning::updateResult()
 {
-    Q_ASSERT(count > 0);
-    Q_ASSERT(!_values.empty());
-    Q_ASSERT(_values.size() == _width*_height);
+    /// the backend writes into a recycled buffer that views then read as it is.
+    auto points = _framePool->acquire();
+    {
+        const Profiler::Scope scope(_profiler.get(), _profilerTrack, "wait for readback");
+        _backend->finishReadback(*points);
+    }
+    _frame = PointFrame(std::move(points));
+}
 
-    std::uniform_real_distribution<f32> uniform01(0, 1);
-    std::uniform_int_distribution<u32> uidW(0, _width-1);
-    std::uniform_int_distribution<u32> uidH(0, _height-1);
-    std::minstd_rand0 rng1(time(0));
-    std::minstd_rand0 rng2(time(0) + 1);
+void ElectrostaticHalftoning::computeForceField()
+{
+    /// the cache holds the field of the image alone; fixed particles are added to it afterwards.
+    std::vector<f32> field;
+    QByteArray key;
+    auto cached = false;
+    if (_forceFieldCache) {
+        /// direct fields also differ with the precision they were summed in.
+        auto method = u32(_forceFieldMethod);
+        if (_forceFieldMethod == ForceFieldMethod::Direct) {
+            method |= u32(precision(Stage::ForceField)) << 8;
+        }
+        key = ForceFieldCache::key(_values, _width, _height, method);
+        if (const auto entry = _forceFieldCache->load(key, _width, _height)) {
+            if (_fixedParticles.empty()) {
+                _backend->setForceField(entry->field, _width, _height);
+                emit forceFieldGenerated();
+                return;
+            }
+            field.assign(entry->field.begin(), entry->field.end());
+            cached = true;
+        }
+    }
 
-    std::vector<compute::float2_> tmp; tmp.reserve(count);
+    if (!cached) {
+        switch (_forceFieldMethod) {
+            case ForceFieldMethod::Direct:
+                _backend->computeForceField(_values, _width, _height);
+                if (_forceFieldCache || !_fixedParticles.empty()) {
+                    _backend->forceField(field);
+                }
+                break;
+            case ForceFieldMethod::Fft: {
+                const Profiler::Scope scope(_profiler.get(), _profilerTrack, "fft force field");
+                auto charges = std::vector<f32>(_values.size());
+                std::ranges::transform(_values, charges.begin(), [](auto x) { return 1.f - x; });
+                field = _forceFieldConvolution.apply(charges, _width, _height);
+                break;
+            }
+        }
 
-    i32 i = count;
-    while (i > 0) {
-        const auto col = uidW(rng1);
-        const auto row = uidH(rng1);
-        const auto val = _values[toIndex(row, col, _width)];
+        if (_forceFieldCache && !_forceFieldCache->store(key, field, _width, _height)) {
+            std::println(stderr, "cannot write to the force field cache in {}", _forceFieldCache->directory().toStdString());
+        }
+    }
+
+    /// a direct field without fixed particles is already on the device.
+    if (!_fixedParticles.empty()) {
+        addFixedParticles(field);
+    }
+    if (cached || _forceFieldMethod == ForceFieldMethod::Fft || !_fixedParticles.empty()) {
+        _backend->setForceField(field, _width, _height);
+    }
 
-        if (uniform01(rng2) >= val) {
-            i--;
-            f32 x = col + uniform01(rng2);
-            f32 y = row + uniform01(rng2);
+    emit forceFieldGenerated();
+}
 
-            Q_ASSERT(x >= 0 && x < _width);
-            Q_ASSERT(y >= 0 && y < _height);
+void ElectrostaticHalftoning::addFixedParticles(std::vector<f32>& field)
+{
+    const Profiler::Scope scope(_profiler.get(), _profilerTrack, "fixed particles");
 
-            tmp.push_back({x, y});
+    auto charges = std::vector<f32>(_values.size());
+    auto add = [&](i32 col, i32 row, f32 charge) {
+        if (col >= 0 && row >= 0 && col < i32(_width) && row < i32(_height)) {
+            charges[std::size_t(row) * _width + col] += charge;
         }
+    };
+    for (const auto& p : _fixedParticles) {
+        const auto col = i32(std::floor(p.x));
+        const auto row = i32(std::floor(p.y));
+        const auto fx  = p.x - f32(col);
+        const auto fy  = p.y - f32(row);
+        add(col,     row,     (1 - fx) * (1 - fy));
+        add(col + 1, row,     fx * (1 - fy));
+        add(col,     row + 1, (1 - fx) * fy);
+        add(col + 1, row + 1, fx * fy);
     }
 
-    _results.resize(count);
-    _particles_k0.resize(count);
-    _particles_k1.resize(count);
+    /// the kernels move a particle by the pull of the field minus radius times the push.
+    const auto push = _forceFieldConvolution.apply(charges, _width, _height);
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        field[i] -= _radius * push[i];
+    }
+}
+
+void ElectrostaticHalftoning::initializeParticles(i32 count)
+{
+    Q_ASSERT(count > 0);
+    Q_ASSERT(!_values.empty());
+    Q_ASSERT(_values.size() == _width*_height);
 
-    compute::copy(tmp.begin(), tmp.end(), _particles_k0.begin(), _queue);
+    _backend->seedParticles(u32(count), _seed);
 }
 
 void ElectrostaticHalftoning::shake()
 {
     const auto c1 = std::max(0.0, (std::log2f(_maxIterations) - 6.0) / 10.0);
     const auto mag = c1 * std::exp(-(_currentIteration+1) / 1000.0);
-    const auto size = _particles_k0.size();
-
-    std::uniform_real_distribution<f32> urd(0, 1);
-    std::minstd_rand rng(time(0));
 
-    std::vector<compute::float2_> tmp; tmp.reserve(_particles_k0.size());
-    for (auto i : std::ranges::iota_view{0u, size}) {
-        auto dis = compute::float2_(urd(rng) * mag, urd(rng) * mag);
-        tmp.push_back(dis);
-    }
-    _shake.resize(_particles_k0.size());
-    compute::copy(tmp.begin(), tmp.end(), _shake.begin(), _queue);
-
-    _shakeKernel = _program.create_kernel("shake");
-    _shakeKernel.set_arg(0, _particles_k0.get_buffer());
-    _shakeKernel.set_arg(1, _shake.get_buffer());
-    _queue.enqueue_1d_range_kernel(_shakeKernel, 0, _particles_k0.size(), 0).wait();
-    _queue.finish();
+    _backend->shake(_seed, u32(_currentIteration), f32(mag));
 }
 
 void ElectrostaticHalftoning::reset()
 {
     _currentIteration = 0;
+
+    _converged = false;
+
+    /// readbacks and measurements of the previous run are waited for and dropped.
+    drain();
+
+    /// parameters may be set before the image; particles are seeded once it arrives.
+    if (_values.empty()) {
+        return;
+    }
     initializeParticles(_particleCount);
-}
\ No newline at end of file
+}
+
+void ElectrostaticHalftoning::drain()
+{
+    while (!_pendingReadbacks.empty()) {
+        _backend->finishReadback(_hostParticles);
+        _pendingReadbacks.pop_front();
+    }
+    while (!_pendingMeasures.empty()) {
+        _backend->finishMeasure();
+        _pendingMeasures.pop_front();
+    }
+}
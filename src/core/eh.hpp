@@ -9,41 +9,108 @@
 ///
 
 
-#include <QObject>
+#include "types.hpp"
+#include "AliasTable.hpp"
+#include "Backend.hpp"
+#include "Device.hpp"
+#include "ForceField.hpp"
+#include "ForceFieldCache.hpp"
+#include "ParticleMesh.hpp"
+#include "PointFrame.hpp"
+#include "PointSet.hpp"
+#include "QuadTree.hpp"
 
-#include <boost/compute/container/vector.hpp>
+#include <QObject>
 
+#include <array>
+#include <deque>
+#include <memory>
 #include <vector>
 
 
-namespace compute = boost::compute;
+namespace core
+{
+    std::vector<f32> normalizedValues(const QImage& image);
 
+    /// which Backend runs the simulation.
+    enum class BackendType
+    {
+        Auto,       ///< OpenCL on a GPU if there is one, otherwise Native; EH_BACKEND=opencl|native|all overrides.
+        OpenCL,     ///< the default OpenCL device, whatever its type.
+        Native,     ///< multithreaded host code.
+        AllDevices, ///< every OpenCL device, sharing the particles; see allDevices.
+    };
 
-using f32 = float;
-using f64 = double;
-using u32 = std::uint32_t;
-using i32 = std::int32_t;
+    /// how the force field of the input image is obtained.
+    enum class ForceFieldMethod
+    {
+        Direct, ///< exact O(P^2) summation by the backend.
+        Fft,    ///< zero-padded FFT convolution on the host, O(P log P).
+    };
 
+    /// how the push force between particles is evaluated in each iteration.
+    enum class Repulsion
+    {
+        Exact,     ///< all pairs, O(N^2).
+        Tiled,     ///< all pairs like Exact, staged through local memory in tiles.
+        BarnesHut, ///< quadtree approximation controlled by the opening angle, O(N log N).
+        P3M,       ///< particle-particle/particle-mesh split, O(N + G log G).
+    };
 
-namespace core
-{
-    std::vector<f32> normalizedValues(const QImage& image);
+    /// the OpenCL device that type resolves to, or nullptr for the native backend. AllDevices
+    /// resolves to the default device here.
+    std::shared_ptr<Device> selectDevice(BackendType type);
+
+    /// every OpenCL device of every platform. a CPU device with several NUMA nodes is split into
+    /// one sub-device per node by device fission, so that each works on memory close to it.
+    std::vector<std::shared_ptr<Device>> allDevices();
+
+    /// the OpenCL devices that type resolves to; empty for the native backend.
+    std::vector<std::shared_ptr<Device>> selectDevices(BackendType type);
+
+    /// an OpenClBackend on device, or a NativeBackend with the given number of threads
+    /// when device is nullptr.
+    std::unique_ptr<Backend> createBackend(const std::shared_ptr<Device>& device, u32 threads = 0);
+
+    /// a MultiDeviceBackend over several devices, otherwise as above.
+    std::unique_ptr<Backend> createBackend(const std::vector<std::shared_ptr<Device>>& devices, u32 threads = 0);
 
     class ElectrostaticHalftoning final : public QObject
     {
         Q_OBJECT
 
     signals:
-        void iterationFinished(const QVector<QPointF>& points, int iter, int iterMax);
+        void iterationFinished(const core::PointFrame& frame, int iter, int iterMax);
         void forceFieldGenerated();
 
+        /// how far the particles moved in iteration iter; measured on the device and only
+        /// while this signal is connected or a tolerance is set.
+        void convergenceMeasured(const core::Convergence& convergence, int iter);
+
     public:
         ElectrostaticHalftoning(QObject* parent = nullptr);
 
+        ElectrostaticHalftoning(BackendType type, QObject* parent = nullptr);
+
+        ElectrostaticHalftoning(std::unique_ptr<Backend> backend, QObject* parent = nullptr);
+
+        ~ElectrostaticHalftoning() override;
+
+        std::string backendName() const { return _backend->name(); }
+
         i32 currentIteration() const { return _currentIteration; }
 
         i32 maxIterations() const { return _maxIterations; }
 
+        /// true once the last iteration has run, or the particles have converged.
+        bool finished() const { return _converged || _currentIteration >= _maxIterations; }
+
+        /// true if the run stopped early because the particles moved less than the tolerance.
+        bool converged() const { return _converged; }
+
+        /// particle positions after the last iteration.
+        const PointFrame& points() const { return _frame; }
+
         void setValues(const std::vector<f32>& values, u32 width, u32 height);
 
         void setParticleCount(i32 count);
@@ -52,42 +119,142 @@ namespace core
 
         void setMaxIteration(i32 i);
 
+        /// seed of the initial placement and of the shakes; a run is reproducible from its
+        /// seed and parameters, on either backend.
+        void setSeed(u64 seed);
+
+        u64 seed() const { return _seed; }
+
+        /// recomputes the force field of the current image, if there is one, and restarts the run.
+        void setForceFieldMethod(ForceFieldMethod method);
+
+        ForceFieldMethod forceFieldMethod() const { return _forceFieldMethod; }
+
+        /// where force fields are looked up before computing them and stored after;
+        /// nullptr disables caching. defaults to a cache in the user's cache location.
+        void setForceFieldCache(std::shared_ptr<const ForceFieldCache> cache);
+
+        const std::shared_ptr<const ForceFieldCache>& forceFieldCache() const { return _forceFieldCache; }
+
+        /// particles held in place, in the pixels of the values, that push the simulated ones like
+        /// any other particle; e.g. the finished neighbours of a tile. their push, with the current
+        /// radius, is added to the force field at pixel resolution, from the next setValues on.
+        void setFixedParticles(std::vector<compute::float2_> points);
+
+        /// how the sums of stage are accumulated; the force field stage only applies to
+        /// ForceFieldMethod::Direct. defaults to double for the force field and float for the
+        /// repulsion, and double falls back to mixed on devices without it.
+        void setPrecision(Stage stage, Precision precision);
+
+        /// the precision stage runs in, which is lower than the one set if the backend lacks it.
+        Precision precision(Stage stage) const { return _precision[std::size_t(stage)]; }
+
+        void setRepulsion(Repulsion method);
+
+        Repulsion repulsion() const { return _repulsion; }
+
+        /// Barnes-Hut opening angle; smaller is more accurate and slower.
+        void setOpeningAngle(f32 theta);
+
+        /// work-group (tile) size and particles per work-item (1 to 4) of the tiled kernel;
+        /// OpenCL devices use the ones tuned for them instead once there are any (see Device::autotune).
+        void setTiling(u32 tileSize, u32 particlesPerItem);
+
+        /// iterations between two readbacks of the positions, each followed by iterationFinished;
+        /// the last iteration is always read back. a readback is emitted during the next
+        /// iteration, which computes while it is being transferred. 0 reads back only the last one, so a run
+        /// of the exact or tiled methods never waits for the device until it ends.
+        void setReadbackInterval(i32 interval);
+
+        i32 readbackInterval() const { return _readbackInterval; }
+
+        /// stops the run, about one iteration later, once no particle moved more than tolerance
+        /// pixels in an iteration; 0 always runs all iterations.
+        void setTolerance(f32 tolerance);
+
+        f32 tolerance() const { return _tolerance; }
+
+        /// records the kernels and transfers of the backend and the host stages of each
+        /// iteration into profiler; nullptr stops. a profiler can be shared by several runs.
+        void setProfiler(std::shared_ptr<Profiler> profiler);
+
+        const std::shared_ptr<Profiler>& profiler() const { return _profiler; }
+
+        /// writes the current particles and what resume() needs to path; waits for the device.
+        bool checkpoint(const QString& path);
+
+        /// checkpoints to path every interval iterations and after the last one; 0 stops.
+        void setCheckpoint(const QString& path, i32 interval);
+
+        /// continues the run a point set was checkpointed from: its particles, iteration, radius,
+        /// seed and iteration count replace the current ones. the shakes only depend on the seed
+        /// and the iteration, so the rest of the run is the same as if it had not stopped. false
+        /// if the point set belongs to another image than the one set with setValues.
+        bool resume(const PointSet& set);
+
         void nextIteration();
 
+        /// runs the remaining iterations.
+        void run();
+
     private:
         void updateResult();
 
+        /// waits for the oldest measurement, emits it and checks it against the tolerance.
+        void takeMeasure();
+
         void computeForceField();
 
+        /// subtracts the push of the fixed particles from field: they are spread bilinearly over
+        /// their four nearest pixels as unit charges and convolved like the image.
+        void addFixedParticles(std::vector<f32>& field);
+
         void initializeParticles(i32 count);
 
         void shake();
 
         void reset();
 
+        /// waits for and drops the readbacks and measurements in flight.
+        void drain();
+
 
         i32 _particleCount{1024*4};
         i32 _currentIteration{0};
         i32 _maxIterations{16};
+        i32 _readbackInterval{1};
+        f32 _tolerance{0};
+        bool _converged{false};
+        u64 _seed{0};
+        u64 _fingerprint{0};
+        QString _checkpointPath;
+        i32 _checkpointInterval{0};
         u32 _width{1};
         u32 _height{1};
         f32 _radius{1};
-
-        compute::vector<compute::float2_> _forceField;
-        compute::vector<compute::float2_> _particles_k0;
-        compute::vector<compute::float2_> _particles_k1;
-        compute::vector<compute::float2_> _shake;
-
+        ForceFieldMethod _forceFieldMethod{ForceFieldMethod::Fft};
+        FieldConvolution _forceFieldConvolution{coulomb};
+        std::shared_ptr<const ForceFieldCache> _forceFieldCache{std::make_shared<ForceFieldCache>()};
+        Repulsion _repulsion{Repulsion::Exact};
+        std::array<Precision, 2> _precision{Precision::Double, Precision::Float}; ///< indexed by Stage, as used.
+        f32 _theta{0.5};
+        u32 _tileSize{128};
+        u32 _particlesPerItem{2};
+        AliasTable _density;
+        QuadTree _quadTree;
+        ParticleMesh _particleMesh;
+
+        std::unique_ptr<Backend> _backend;
+        std::shared_ptr<Profiler> _profiler;
+        u32 _profilerTrack{0};
+        std::vector<compute::float2_> _hostParticles;
+        std::deque<i32> _pendingReadbacks; ///< iterations whose readback has begun.
+        std::deque<i32> _pendingMeasures;  ///< iterations whose measurement has begun.
         std::vector<f32> _values;
-        compute::vector<f32> _values_dev;
-        QVector<QPointF> _results;
-
-        compute::context _context;
-        compute::command_queue _queue;
-        compute::program _program;
-
-        compute::kernel _forceFieldKernel;
-        compute::kernel _iterateKernel;
-        compute::kernel _shakeKernel;
+        std::vector<compute::float2_> _fixedParticles;
+        std::shared_ptr<PointFramePool> _framePool{PointFramePool::create()};
+        PointFrame _frame;
     };
-}
\ No newline at end of file
+}
+
+Q_DECLARE_METATYPE(core::Convergence)
@@ -1,7 +1,7 @@
 BOOST_COMPUTE_STRINGIZE_SOURCE(
 
-/// given a position, compute the pull force using bilinear interpolation.
-__kernel void computePullForce(__global const float2* forceField, const float2 pos, uint width, __local float2* output)
+/// bilinear interpolation of a float2 field sampled at integer positions, row-major with a stride of width.
+float2 bilinear(__global const float2* field, const float2 pos, uint width)
 {
     float2 xy1  = floor(pos);
     float2 ones = {1, 1};
@@ -17,25 +17,121 @@ __kernel void computePullForce(__global const float2* forceField, const float2 p
     uint i1  = row     * width + col;
     uint i2  = (row+1) * width + col;
 
-    *output = weight.x * forceField[i1  ]
-            + weight.y * forceField[i1+1]
-            + weight.z * forceField[i2  ]
-            + weight.w * forceField[i2+1];
+    return weight.x * field[i1  ]
+         + weight.z * field[i1+1]
+         + weight.y * field[i2  ]
+         + weight.w * field[i2+1];
+}
+
+/// running float2 sum whose precision the program is built with (see Device.hpp):
+/// EH_ACCUMULATOR is float2 or double2, converted to with EH_CONVERT, and EH_COMPENSATED
+/// selects Kahan summation, which carries the rounding error of every addition along.
+typedef struct
+{
+    EH_ACCUMULATOR sum;
+    EH_ACCUMULATOR error;
+} accumulator;
+
+accumulator accumulatorWith(float2 x)
+{
+    accumulator a;
+    a.sum   = EH_CONVERT(x);
+    a.error = EH_CONVERT((float2)(0, 0));
+    return a;
 }
 
-__kernel void shake(__global float2* points, __global float2* jitter)
+void accumulate(accumulator* a, float2 x)
+{
+    if (EH_COMPENSATED) {
+        EH_ACCUMULATOR y = EH_CONVERT(x) - a->error;
+        EH_ACCUMULATOR t = a->sum + y;
+        a->error = (t - a->sum) - y;
+        a->sum   = t;
+    } else {
+        a->sum += EH_CONVERT(x);
+    }
+}
+
+float2 accumulated(accumulator a)
+{
+    return convert_float2(a.sum - a.error);
+}
+
+/// given a position, compute the pull force using bilinear interpolation.
+__kernel void computePullForce(__global const float2* forceField, const float2 pos, uint width, __local float2* output)
+{
+    *output = bilinear(forceField, pos, width);
+}
+
+/// moves Pn by the pull of the force field and the push of the other particles.
+/// a particle that would leave the image stays where it is.
+float2 advance(__global const float2* forceField, uint w, float2 boundry, float radius, float2 Pn, float2 pushForce)
+{
+    float2 pullForce  = bilinear(forceField, Pn, w);
+
+    float tau         = 0.1;
+    float2 totalForce = (pullForce - pushForce * radius);
+    float2 newPn      = Pn + totalForce * tau;
+
+    if (newPn.x < 0 || newPn.y < 0 || newPn.x > boundry.x || newPn.y > boundry.y) {
+        newPn = Pn;
+    }
+
+    return newPn;
+}
+
+/// Philox4x32-10 counter-based generator; same as philox() in Philox.hpp.
+uint4 philox(uint4 counter, uint2 key)
+{
+    for (uint round = 0; round < 10; ++round) {
+        uint hi0 = mul_hi(0xD2511F53u, counter.x);
+        uint lo0 = 0xD2511F53u * counter.x;
+        uint hi1 = mul_hi(0xCD9E8D57u, counter.z);
+        uint lo1 = 0xCD9E8D57u * counter.z;
+
+        counter = (uint4)(hi1 ^ counter.y ^ key.x, lo1, hi0 ^ counter.w ^ key.y, lo0);
+        key    += (uint2)(0x9E3779B9u, 0xBB67AE85u);
+    }
+    return counter;
+}
+
+/// [0, 1) from the upper 24 bits of x.
+float uniform(uint x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+/// moves every particle by magnitude times a [0, 1)^2 jitter from the stream of (particle, iteration).
+__kernel void shake(__global float2* points, uint2 key, uint iteration, float magnitude)
 {
     uint gid = get_global_id(0);
+    uint4 r  = philox((uint4)(gid, iteration, 0, 0), key);
+
+    points[gid] += magnitude * (float2)(uniform(r.x), uniform(r.y));
+}
+
+/// places particle gid in a pixel drawn from the alias table of the image's darkness, and
+/// uniformly inside that pixel.
+__kernel void seedParticles(__global float2* points, __global const float* probabilities, __global const uint* aliases,
+                            uint pixels, uint w, uint2 key)
+{
+    uint gid   = get_global_id(0);
+    uint4 r    = philox((uint4)(gid, 0, 1, 0), key);
+    uint pixel = mul_hi(r.x, pixels);
 
-    points[gid] += jitter[gid];
+    if (uniform(r.y) >= probabilities[pixel]) {
+        pixel = aliases[pixel];
+    }
+
+    points[gid] = (float2)(pixel % w + uniform(r.z), pixel / w + uniform(r.w));
 }
 
 __kernel void computeForceField(__global const float* values, __global float2* forceField, uint w, uint h)
 {
     uint gid = get_global_id(0);
 
+    /// the work-items padding the range to a multiple of the work-group size.
     if (gid >= w*h) {
-        /// this should never happen!
         return;
     }
 
@@ -43,7 +139,7 @@ __kernel void computeForceField(__global const float* values, __global float2* f
     PosP.x = gid % w;
     PosP.y = gid / w;
 
-    double2 totalForce = {0, 0};
+    accumulator totalForce = accumulatorWith((float2)(0, 0));
     float2 PosG = {0, 0};
 
     for (uint rowG = 0; rowG < h; ++rowG) {
@@ -53,7 +149,7 @@ __kernel void computeForceField(__global const float* values, __global float2* f
                 float charge = 1.0f - values[indexG];
                 float2 e_pg  = PosG - PosP;
                 float force  = charge / dot(e_pg, e_pg);
-                totalForce += convert_double2(force * normalize(e_pg));
+                accumulate(&totalForce, force * normalize(e_pg));
             }
             PosG.x += 1;
         }
@@ -61,16 +157,21 @@ __kernel void computeForceField(__global const float* values, __global float2* f
         PosG.y += 1;
     }
 
-    forceField[gid] = convert_float2(totalForce);
+    forceField[gid] = accumulated(totalForce);
 }
 
-__kernel void iterate(__global float2* points, __global float2* result, __global const float2* forceField, uint w, float2 boundry, float radius)
+/// advances the particles of the range it is enqueued over (the global offset and size) below
+/// end, each pushed by all N of them. the range may be padded to a multiple of the work-group size.
+__kernel void iterate(__global float2* points, __global float2* result, __global const float2* forceField, uint w, float2 boundry, float radius,
+                      uint N, uint end)
 {
     uint gid = get_global_id(0);
-    uint N   = get_global_size(0);
+    if (gid >= end) {
+        return;
+    }
 
-    float2 Pn        = points[gid];
-    float2 pushForce = {0, 0};
+    float2 Pn             = points[gid];
+    accumulator pushForce = accumulatorWith((float2)(0, 0));
 
     for (uint j = 0; j < N; ++j) {
         if (j != gid) {
@@ -80,25 +181,212 @@ __kernel void iterate(__global float2* points, __global float2* result, __global
             }
             float2 e_nm = Pm - Pn;
             float force = 1.0f / dot(e_nm, e_nm);
-            pushForce += force * normalize(e_nm) ;
+            accumulate(&pushForce, force * normalize(e_nm));
         }
     }
 
-    __local float2 pullForce;
-    computePullForce(forceField, Pn, w, &pullForce);
+    result[gid] = advance(forceField, w, boundry, radius, Pn, accumulated(pushForce));
+}
 
-    float tau         = 0.1;
-    float2 totalForce = (pullForce - pushForce * radius);
-    float2 newPn      = Pn + totalForce * tau;
+/// same result as iterate, with the particles staged through local memory one tile at a time.
+/// the work-group size is the tile size, and every work-item advances up to four particles,
+/// gid + k * get_global_size(0) for k < perItem, of those below end. coincident particles,
+/// including Pn itself, contribute nothing because their inverse distance is selected to zero.
+__kernel void iterateTiled(__global const float2* points, __global float2* result, __global const float2* forceField, uint w, float2 boundry, float radius,
+                           uint n, uint perItem, __local float2* tile, uint end)
+{
+    uint gid      = get_global_id(0);
+    uint lid      = get_local_id(0);
+    uint stride   = get_global_size(0);
+    uint tileSize = get_local_size(0);
 
-    float2 zero = {0, 0};
+    float2 Pn[4];
+    accumulator pushForce[4];
 
-    if (newPn.x < 0 || newPn.y < 0 || newPn.x > boundry.x || newPn.y > boundry.y) {
-        newPn = Pn;
+    for (uint k = 0; k < perItem; ++k) {
+        uint i       = min(gid + k * stride, n - 1);
+        Pn[k]        = points[i];
+        pushForce[k] = accumulatorWith((float2)(0, 0));
     }
 
-    result[gid] = newPn;
+    for (uint base = 0; base < n; base += tileSize) {
+        uint count = min(tileSize, n - base);
+        if (lid < count) {
+            tile[lid] = points[base + lid];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (uint j = 0; j < count; ++j) {
+            float2 Pm = tile[j];
+            for (uint k = 0; k < perItem; ++k) {
+                float2 e_nm = Pm - Pn[k];
+                float d2    = dot(e_nm, e_nm);
+                float inv   = d2 > 0 ? rsqrt(d2) : 0;
+                accumulate(&pushForce[k], (inv * inv * inv) * e_nm);
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    for (uint k = 0; k < perItem; ++k) {
+        uint i = gid + k * stride;
+        if (i < end) {
+            result[i] = advance(forceField, w, boundry, radius, Pn[k], accumulated(pushForce[k]));
+        }
+    }
+}
+
+/// same as iterate, but the push force is approximated with a Barnes-Hut quadtree
+/// (see QuadTree.hpp for the layout of nodes and links).
+/// a node whose side length over distance is below theta acts as a single charge.
+__kernel void iterateBarnesHut(__global const float2* points, __global float2* result, __global const float2* forceField, uint w, float2 boundry, float radius,
+                               __global const float4* nodes, __global const uint4* links, uint nodeCount, __global const float2* treePoints, float theta,
+                               uint end)
+{
+    uint gid = get_global_id(0);
+    if (gid >= end) {
+        return;
+    }
+
+    float2 Pn             = points[gid];
+    accumulator pushForce = accumulatorWith((float2)(0, 0));
+    float theta2          = theta * theta;
+
+    uint i = 0;
+    while (i < nodeCount) {
+        float4 node = nodes[i];
+        uint4 link  = links[i];
+
+        if (link.x == 0) {
+            /// leaf, exact interaction with every particle in it.
+            for (uint j = link.z; j < link.w; ++j) {
+                float2 Pm = treePoints[j];
+                if (isequal(Pm.x, Pn.x) && isequal(Pm.y, Pn.y)) {
+                    continue;
+                }
+                float2 e_nm = Pm - Pn;
+                float force = 1.0f / dot(e_nm, e_nm);
+                accumulate(&pushForce, force * normalize(e_nm));
+            }
+            i = link.y;
+            continue;
+        }
+
+        float2 e_nc = node.xy - Pn;
+        float d2    = dot(e_nc, e_nc);
+
+        if (node.w * node.w < theta2 * d2) {
+            accumulate(&pushForce, (node.z / d2) * normalize(e_nc));
+            i = link.y;
+        } else {
+            i = link.x;
+        }
+    }
+
+    result[gid] = advance(forceField, w, boundry, radius, Pn, accumulated(pushForce));
+}
+
+/// particle-particle/particle-mesh variant of iterate (see ParticleMesh.hpp).
+/// the long-range push is sampled from meshField, the short-range remainder is summed
+/// over the particles of the neighbouring cells of the cell list.
+__kernel void iterateParticleMesh(__global const float2* points, __global float2* result, __global const float2* forceField, uint w, float2 boundry, float radius,
+                                  __global const float2* meshField, __global const uint* cellStarts, __global const float2* cellPoints, uint2 cells, float cutoff,
+                                  uint end)
+{
+    uint gid = get_global_id(0);
+    if (gid >= end) {
+        return;
+    }
+
+    float2 Pn             = points[gid];
+    accumulator pushForce = accumulatorWith(bilinear(meshField, Pn, w));
+
+    int col = Pn.x / cutoff;
+    int row = Pn.y / cutoff;
+
+    for (int r = max(row - 1, 0); r <= min(row + 1, (int)cells.y - 1); ++r) {
+        for (int c = max(col - 1, 0); c <= min(col + 1, (int)cells.x - 1); ++c) {
+            uint cell = r * cells.x + c;
+            for (uint j = cellStarts[cell]; j < cellStarts[cell + 1]; ++j) {
+                float2 Pm = cellPoints[j];
+                if (isequal(Pm.x, Pn.x) && isequal(Pm.y, Pn.y)) {
+                    continue;
+                }
+                float2 e_nm = Pm - Pn;
+                float d     = length(e_nm);
+                if (d < cutoff) {
+                    float x     = d / cutoff;
+                    float s     = x * x * x * (x * (6 * x - 15) + 10);
+                    float force = (1.0f - s) / (d * d);
+                    accumulate(&pushForce, force * (e_nm / d));
+                }
+            }
+        }
+    }
+
+    result[gid] = advance(forceField, w, boundry, radius, Pn, accumulated(pushForce));
+}
+
+/// max, sum and sum of squares of |after - before| over the particles this work-group visits,
+/// reduced in local memory; the work-group size must be a power of two.
+__kernel void measureDisplacement(__global const float2* before, __global const float2* after, uint n,
+                                  __global float4* partials, __local float4* scratch)
+{
+    uint lid   = get_local_id(0);
+    float4 acc = (float4)(0, 0, 0, 0);
+
+    for (uint i = get_global_id(0); i < n; i += get_global_size(0)) {
+        float d = distance(after[i], before[i]);
+        acc.x   = max(acc.x, d);
+        acc.y  += d;
+        acc.z  += d * d;
+    }
+
+    scratch[lid] = acc;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (uint stride = get_local_size(0) / 2; stride > 0; stride >>= 1) {
+        if (lid < stride) {
+            float4 other     = scratch[lid + stride];
+            scratch[lid].x   = max(scratch[lid].x, other.x);
+            scratch[lid].yz += other.yz;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        partials[get_group_id(0)] = scratch[0];
+    }
+}
+
+/// reduces count partials of measureDisplacement into result[slot], in a single work-group.
+__kernel void reduceDisplacement(__global const float4* partials, uint count, __global float4* result, uint slot,
+                                 __local float4* scratch)
+{
+    uint lid   = get_local_id(0);
+    float4 acc = (float4)(0, 0, 0, 0);
+
+    for (uint i = lid; i < count; i += get_local_size(0)) {
+        acc.x   = max(acc.x, partials[i].x);
+        acc.yz += partials[i].yz;
+    }
+
+    scratch[lid] = acc;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (uint stride = get_local_size(0) / 2; stride > 0; stride >>= 1) {
+        if (lid < stride) {
+            float4 other     = scratch[lid + stride];
+            scratch[lid].x   = max(scratch[lid].x, other.x);
+            scratch[lid].yz += other.yz;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        result[slot] = scratch[0];
+    }
 }
 
 
-);
\ No newline at end of file
+);
@@ -4,6 +4,7 @@
 #include "ControlPanel.hpp"
 #include "Slider.hpp"
 
+#include <QComboBox>
 #include <QDoubleValidator>
 #include <QGridLayout>
 #include <QLabel>
@@ -42,6 +43,30 @@ namespace
 
         return lineEdit;
     }
+
+    /// pixels a particle may move in an iteration before the run stops; 0 runs every iteration.
+    auto createToleranceLineEdit(QWidget* parent = nullptr)
+    {
+        auto* lineEdit  = new QLineEdit(parent);
+        auto* validator = new QDoubleValidator(0.0, 8.0, 4, lineEdit);
+        validator->setNotation(QDoubleValidator::StandardNotation);
+        validator->setLocale(QLocale::C);
+        lineEdit->setValidator(validator);
+        lineEdit->setText("0");
+
+        return lineEdit;
+    }
+
+    auto createRepulsionComboBox(QWidget* parent = nullptr)
+    {
+        auto* comboBox = new QComboBox(parent);
+        comboBox->addItem("Exact", QVariant::fromValue(core::Repulsion::Exact));
+        comboBox->addItem("Exact (tiled)", QVariant::fromValue(core::Repulsion::Tiled));
+        comboBox->addItem("Barnes-Hut", QVariant::fromValue(core::Repulsion::BarnesHut));
+        comboBox->addItem("P3M", QVariant::fromValue(core::Repulsion::P3M));
+
+        return comboBox;
+    }
 }
 
 ControlPanel::ControlPanel(QWidget* parent)
@@ -58,6 +83,10 @@ ControlPanel::ControlPanel(QWidget* parent)
     auto* iterations  = new Slider("Iterations", powerOfTwos(0, 12), 4, this);
     auto* radiusLabel = new QLabel("Radius", this);
     auto* radiusEdit  = createRadiusLineEdit(this);
+    auto* repulsion   = createRepulsionComboBox(this);
+    auto* readback    = new Slider("Readback", powerOfTwos(0, 6), 0, this);
+    auto* toleranceLabel = new QLabel("Tolerance", this);
+    auto* toleranceEdit  = createToleranceLineEdit(this);
 
     /// connections
     connect(particles, &Slider::valueChanged, [this](const QVariant &val) {
@@ -78,15 +107,38 @@ ControlPanel::ControlPanel(QWidget* parent)
             }
         }
     });
+    connect(readback, &Slider::valueChanged, [this](const QVariant &val) {
+        if (val.canConvert<int>()) {
+            emit readbackIntervalChanged(val.value<int>());
+        }
+    });
+    connect(toleranceEdit, &QLineEdit::textEdited, [this, toleranceEdit](const QString &text) {
+        if (toleranceEdit->hasAcceptableInput()) {
+            auto ok = false;
+            if (const auto value = text.toDouble(&ok); ok) {
+                emit toleranceChanged(value);
+            }
+        }
+    });
+    connect(repulsion, &QComboBox::currentIndexChanged, [this, repulsion](int index) {
+        emit repulsionChanged(repulsion->itemData(index).value<core::Repulsion>());
+    });
 
     /// placement
     auto row = 0;
     auto col = 0;
     layout->addWidget(particles,  row, col++, 1, 1);
+    layout->addWidget(repulsion,  row, col++, 1, 3);
 
     col = 0;
     row++;
     layout->addWidget(iterations,  row, col++, 1, 1);
     layout->addWidget(radiusLabel, row, col++, 1, 1);
     layout->addWidget(radiusEdit,  row, col++, 1, 2);
+
+    col = 0;
+    row++;
+    layout->addWidget(readback,       row, col++, 1, 1);
+    layout->addWidget(toleranceLabel, row, col++, 1, 1);
+    layout->addWidget(toleranceEdit,  row, col++, 1, 2);
 }
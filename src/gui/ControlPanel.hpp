@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "core/eh.hpp"
+
 #include <QWidget>
 
 
@@ -19,6 +21,9 @@ namespace gui
         void particleRadiusChanged(qreal radius);
         void particleCountChanged(int count);
         void iterationCountChanged(int count);
+        void repulsionChanged(core::Repulsion method);
+        void readbackIntervalChanged(int interval);
+        void toleranceChanged(qreal tolerance);
 
     public:
         explicit ControlPanel(QWidget* parent = nullptr);
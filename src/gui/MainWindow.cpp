@@ -8,15 +8,21 @@
 #include "ControlPanel.hpp"
 
 #include "core/Controller.hpp"
+#include "core/FrameMailbox.hpp"
+#include "core/PointSet.hpp"
 
+#include <QApplication>
 #include <QFileDialog>
 #include <QLabel>
 #include <QMenuBar>
+#include <QScreen>
 #include <QSplitter>
 #include <QStackedLayout>
 #include <QTimer>
 #include <QVBoxLayout>
 
+#include <print>
+
 
 using namespace gui;
 
@@ -28,9 +34,16 @@ MainWindow::MainWindow()
 
     auto* mb = new QMenuBar(this);
     auto* fileMenu = mb->addMenu("File");
+    auto* openPointsAction = fileMenu->addAction("Open Points");
+    auto* savePointsAction = fileMenu->addAction("Save Points");
+    savePointsAction->setDisabled(true);
     auto* exportAction = fileMenu->addAction("Export SVG");
     exportAction->setDisabled(true);
     fileMenu->addSeparator();
+    auto* stopAction = fileMenu->addAction("Stop");
+    stopAction->setShortcut(Qt::Key_Escape);
+    stopAction->setDisabled(true);
+    fileMenu->addSeparator();
     auto* quitAction = fileMenu->addAction("Quit");
     layout->addWidget(mb);
 
@@ -57,8 +70,18 @@ MainWindow::MainWindow()
     timer->setInterval(125);
 
 
-    /// notify ParticlesView to redraw whenever particles have changed.
-    connect(core::controller(), &core::Controller::generated, particlesView, &ParticlesView::particlesChanged);
+    /// notify ParticlesView to redraw whenever particles have changed, at most once per display
+    /// refresh. frames arrive in the mailbox straight from the controller's thread, so a slow
+    /// repaint drops frames instead of holding back the simulation.
+    auto* mailbox = new core::FrameMailbox(this);
+    mailbox->setRefreshRate(screen()->refreshRate());
+    connect(core::controller(), &core::Controller::generated, mailbox, &core::FrameMailbox::post, Qt::DirectConnection);
+    connect(mailbox, &core::FrameMailbox::delivered, particlesView, &ParticlesView::particlesChanged);
+    connect(core::controller(), &core::Controller::profiled, particlesView, &ParticlesView::profiled);
+
+    connect(core::controller(), &core::Controller::firstFrame, [](qint64 ms) {
+        std::println("first frame after {} ms", ms);
+    });
 
     /// notify UI to show/hide Force Field progress.
     /// ControlPanel is hidden when Force Field is being computed.
@@ -88,20 +111,61 @@ MainWindow::MainWindow()
     connect(ctrlPanel, &ControlPanel::particleRadiusChanged, core::controller(),  &core::Controller::setParticleRadius);
     /// notify controller whenever the user changes the iteration count.
     connect(ctrlPanel, &ControlPanel::iterationCountChanged, core::controller(), &core::Controller::setIterationCount);
+    /// notify controller whenever the user changes how particles repel each other.
+    connect(ctrlPanel, &ControlPanel::repulsionChanged, core::controller(), &core::Controller::setRepulsion);
+    /// notify controller whenever the user changes how often particles are shown.
+    connect(ctrlPanel, &ControlPanel::readbackIntervalChanged, core::controller(),
+            &core::Controller::setReadbackInterval);
+    /// notify controller whenever the user changes when a run may stop early.
+    connect(ctrlPanel, &ControlPanel::toleranceChanged, core::controller(), &core::Controller::setTolerance);
+
+    /// stops the run in progress after its current iteration; the particles stay as they are.
+    connect(core::controller(), &core::Controller::forceFieldStarted, stopAction, [stopAction] {
+        stopAction->setEnabled(true);
+    });
+    connect(stopAction, &QAction::triggered, [] {
+        QMetaObject::invokeMethod(core::controller(), &core::Controller::cancel);
+    });
 
     /// SVG export
-    connect(core::controller(), &core::Controller::forceFieldStarted, [exportAction] {
+    connect(core::controller(), &core::Controller::forceFieldStarted, [exportAction, savePointsAction] {
         exportAction->setEnabled(false);
+        savePointsAction->setEnabled(false);
     });
-    connect(core::controller(), &core::Controller::forceFieldGenerated, exportAction, [exportAction] {
+    connect(core::controller(), &core::Controller::forceFieldGenerated, exportAction, [exportAction, savePointsAction] {
         exportAction->setEnabled(true);
+        savePointsAction->setEnabled(true);
     });
     connect(exportAction, &QAction::triggered, [this, imageView] {
-        auto path = QFileDialog::getSaveFileName(this, "Export SVG", QDir::homePath(), "Files (*.svg)");
+        auto path = QFileDialog::getSaveFileName(this, "Export SVG", QDir::homePath(), "SVG (*.svg);;Compressed SVG (*.svgz)");
+        if (!path.isEmpty()) {
+            const auto& image = imageView->image();
+            emit exportSvgTriggered(path, image.isNull() ? _pointSetSize : image.size());
+        }
+    });
+
+    /// point sets: the current particles are saved between two iterations; an opened set is
+    /// shown and exported like a finished run.
+    connect(savePointsAction, &QAction::triggered, [this] {
+        auto path = QFileDialog::getSaveFileName(this, "Save Points", QDir::homePath(), "Point sets (*.ehp)");
         if (!path.isEmpty()) {
-            emit exportSvgTriggered(path, imageView->image().size());
+            QMetaObject::invokeMethod(core::controller(), [path] { core::controller()->checkpoint(path); });
         }
     });
+    connect(openPointsAction, &QAction::triggered, [this, particlesView, exportAction] {
+        auto path = QFileDialog::getOpenFileName(this, "Open Points", QDir::homePath(), "Point sets (*.ehp)");
+        if (path.isEmpty()) {
+            return;
+        }
+        const auto set = core::PointSet::load(path);
+        if (!set) {
+            std::println("cannot read {}", path.toStdString());
+            return;
+        }
+        _pointSetSize = QSize(set->info().width, set->info().height);
+        emit particlesView->particlesChanged(set->frame(), set->info().iteration, set->info().iteration, 0);
+        exportAction->setEnabled(true);
+    });
 
     connect(this, &MainWindow::exportSvgTriggered, particlesView, &ParticlesView::exportSvg);
 }
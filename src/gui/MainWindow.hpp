@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <QSize>
 #include <QWidget>
 
 
@@ -18,5 +19,8 @@ namespace gui
 
     public:
         MainWindow();
+
+    private:
+        QSize _pointSetSize; ///< image size of the last point set opened.
     };
 }
\ No newline at end of file
@@ -4,11 +4,14 @@
 
 #include "ParticlesView.hpp"
 
+#include "core/Export.hpp"
+
 #include <QPainter>
 #include <QPushButton>
 #include <QTimer>
 #include <QVBoxLayout>
-#include <QSvgGenerator>
+
+#include <ranges>
 
 
 using namespace gui;
@@ -21,9 +24,13 @@ View::View(QWidget* parent)
     connect(_timer, &QTimer::timeout, this, &View::clearInfo);
 }
 
-void View::draw(const QVector<QPointF>& points, int iter, int iterMax)
+void View::draw(const core::PointFrame& frame, int iter, int iterMax, int dropped)
 {
-    _points  = points;
+    /// a run restarts from its first iteration.
+    _dropped = iter > _iter ? _dropped + dropped : dropped;
+
+    _frame   = frame;
+    _renderer.setFrame(frame);
     _iter    = iter;
     _iterMax = iterMax;
     update();
@@ -33,6 +40,7 @@ void View::zoomIn()
 {
     _scale = qBound(0.25, _scale + 0.25, 4.0);
     _info  = QString("Zoom %1x").arg(_scale);
+    _renderer.setScale(_scale);
 
     _timer->start(2000);
     update();
@@ -42,6 +50,7 @@ void View::zoomOut()
 {
     _scale = qBound(0.25, _scale - 0.25, 4.0);
     _info  = QString("Zoom %1x").arg(_scale);
+    _renderer.setScale(_scale);
 
     _timer->start(2000);
     update();
@@ -51,6 +60,7 @@ void View::increaseDotSize()
 {
     _dotRadius = qBound(0.25, _dotRadius + 0.25, 8.0);
     _info      = QString("Dot Radius= %1px").arg(_dotRadius);
+    _renderer.setDotRadius(_dotRadius);
 
     _timer->start(2000);
     update();
@@ -60,6 +70,7 @@ void View::decreaseDotSize()
 {
     _dotRadius = qBound(0.25, _dotRadius - 0.25, 8.0);
     _info      = QString("Dot Radius= %1px").arg(_dotRadius);
+    _renderer.setDotRadius(_dotRadius);
 
     _timer->start(2000);
     update();
@@ -67,22 +78,19 @@ void View::decreaseDotSize()
 
 void View::exportSvg(const QString& path, const QSize& size)
 {
-    QSvgGenerator generator;
-    generator.setFileName(path);
-    const auto width  = size.width() * _scale + _dotRadius*2.0;
-    const auto height = size.height() * _scale + _dotRadius*2.0;
-    generator.setSize(QSize(width, height));
-    generator.setViewBox(QRectF(-_dotRadius, -_dotRadius, width, height));
-
-    QPainter painter(&generator);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(Qt::black);
-    for (const auto& p : _points) {
-        painter.drawEllipse(p * _scale, _dotRadius, _dotRadius);
+    if (!core::writeSvg(path, _frame, size, _scale, _dotRadius)) {
+        _info = QString("Cannot write %1").arg(path);
+        _timer->start(2000);
+        update();
     }
 }
 
+void View::showProfile(const std::vector<core::Profiler::Stage>& stages)
+{
+    _stages = stages;
+    update();
+}
+
 void View::clearInfo()
 {
     _info.clear();
@@ -95,12 +103,9 @@ void View::paintEvent(QPaintEvent* event)
     QPainter painter(this);
     painter.fillRect(rect(), Qt::white);
 
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(Qt::black);
-
-    for (const auto& p : _points) {
-        painter.drawEllipse(p * _scale, _dotRadius, _dotRadius);
+    /// the dots are rasterised again only when they, the zoom or the dot size changed.
+    if (const auto& image = _renderer.image(size(), devicePixelRatioF()); !image.isNull()) {
+        painter.drawImage(QPointF(0, 0), image);
     }
 
     if (!_info.isEmpty()) {
@@ -116,11 +121,46 @@ void View::paintEvent(QPaintEvent* event)
         painter.drawText(bbox, Qt::AlignCenter, _info);
     }
 
+    if (!_stages.empty()) {
+        /// the slowest stages first, with their share of the last interval.
+        QStringList lines;
+        for (const auto& stage : _stages | std::views::take(12)) {
+            lines << QString("%1  %2  %3 ms  %4x")
+                         .arg(QString::fromStdString(stage.name), -24)
+                         .arg(QString::fromUtf8(core::toString(stage.category).data()), -8)
+                         .arg(f64(stage.total) / 1e6, 8, 'f', 2)
+                         .arg(stage.count, 5);
+        }
+
+        auto mono = QFont("monospace");
+        mono.setStyleHint(QFont::Monospace);
+        mono.setPointSizeF(font().pointSizeF() * 0.9);
+
+        const auto text = lines.join('\n');
+        auto bbox = QFontMetrics(mono).boundingRect(rect(), Qt::AlignRight | Qt::AlignTop, text);
+        bbox.moveTopRight(rect().topRight() + QPoint(-12, 10));
+
+        painter.setFont(mono);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(255, 255, 255, 208));
+        painter.drawRoundedRect(bbox.adjusted(-6, -4, 6, 4), 2, 2);
+        painter.setPen(QColor(32, 32, 32, 255));
+        painter.drawText(bbox, Qt::AlignLeft | Qt::AlignTop, text);
+        painter.setFont(font());
+    }
+
     if (_iter < _iterMax && _iterMax > 0) {
         const auto bot = rect().bottom()-3; /// 4px thick
         const auto perc = width() * (qreal(_iter)/qreal(_iterMax));
         painter.fillRect(QRect(0, bot, width(), 4), QColor(196, 196, 196, 255));
         painter.fillRect(QRect(0, bot, perc, 4), QColor(32, 196, 64, 255));
+
+        if (_dropped > 0) {
+            painter.setPen(QColor(128, 128, 128, 255));
+            painter.drawText(rect().adjusted(0, 0, -4, -8), Qt::AlignRight | Qt::AlignBottom,
+                             QString("%1 frames skipped").arg(_dropped));
+        }
     }
 }
 
@@ -141,6 +181,7 @@ ParticlesView::ParticlesView(QWidget* parent)
     _decreaseDotSize = new QPushButton("o", this);  _decreaseDotSize->setFixedSize(24, 24);
     connect(this, &ParticlesView::particlesChanged, _view, &View::draw);
     connect(this, &ParticlesView::exportSvg, _view, &View::exportSvg);
+    connect(this, &ParticlesView::profiled, _view, &View::showProfile);
 
     connect(_zoomIn, &QPushButton::clicked, this, &ParticlesView::zoomedIn);
     connect(_zoomOut, &QPushButton::clicked, this, &ParticlesView::zoomedOut);
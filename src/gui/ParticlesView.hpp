@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include "SplatRenderer.hpp"
+#include "core/PointFrame.hpp"
+#include "core/Profiler.hpp"
+
 #include <QWidget>
 
 
@@ -19,13 +23,17 @@ namespace gui
         explicit View(QWidget* parent = nullptr);
 
     public slots:
-        void draw(const QVector<QPointF>& points, int iter, int iterMax);
+        /// dropped is the number of frames skipped before this one, shown while a run is in progress.
+        void draw(const core::PointFrame& frame, int iter, int iterMax, int dropped = 0);
         void zoomIn();
         void zoomOut();
         void increaseDotSize();
         void decreaseDotSize();
         void exportSvg(const QString& path, const QSize& size);
 
+        /// shows the time of every stage in the top right corner, until an empty list comes.
+        void showProfile(const std::vector<core::Profiler::Stage>& stages);
+
     private slots:
         void clearInfo();
 
@@ -36,9 +44,12 @@ namespace gui
         qreal _scale{1};
         int _iter{0};
         int _iterMax{0};
+        int _dropped{0}; ///< frames skipped in the current run.
         QString _info;
+        std::vector<core::Profiler::Stage> _stages;
         QTimer* _timer;
-        QVector<QPointF> _points;
+        core::PointFrame _frame;
+        SplatRenderer _renderer;
     };
 
 
@@ -51,8 +62,9 @@ namespace gui
         void zoomedOut();
         void increasedDotSize();
         void decreasedDotSize();
-        void particlesChanged(const QVector<QPointF>& points, int iter, int iterMax);
+        void particlesChanged(const core::PointFrame& frame, int iter, int iterMax, int dropped);
         void exportSvg(const QString& path, const QSize& size);
+        void profiled(const std::vector<core::Profiler::Stage>& stages);
 
     public:
         explicit ParticlesView(QWidget* parent = nullptr);
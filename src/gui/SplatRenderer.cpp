@@ -0,0 +1,212 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include "SplatRenderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+
+using namespace gui;
+
+namespace
+{
+    /// samples per pixel and axis when the sprites are rasterised.
+    constexpr i32 samples = 8;
+
+    /// composites black of coverage alpha over the grey value dst, like QPainter would.
+    inline uchar over(uchar dst, uchar alpha)
+    {
+        const auto t = u32(dst) * (255 - alpha) + 128;
+        return uchar((t + (t >> 8)) >> 8); /// t / 255, rounded.
+    }
+}
+
+SplatRenderer::SplatRenderer(u32 threads)
+    : _pool(threads)
+{
+}
+
+void SplatRenderer::setFrame(const core::PointFrame& frame)
+{
+    _frame = frame;
+    _dirty = true;
+}
+
+void SplatRenderer::setScale(qreal scale)
+{
+    if (scale != _scale) {
+        _scale = scale;
+        _dirty = true;
+    }
+}
+
+void SplatRenderer::setDotRadius(qreal radius)
+{
+    if (radius != _dotRadius) {
+        _dotRadius  = radius;
+        _spriteSize = 0;
+        _dirty      = true;
+    }
+}
+
+const QImage& SplatRenderer::image(const QSize& viewport, qreal devicePixelRatio)
+{
+    if (devicePixelRatio != _devicePixelRatio) {
+        _devicePixelRatio = devicePixelRatio;
+        _spriteSize       = 0;
+        _dirty            = true;
+    }
+    if (_spriteSize == 0) {
+        buildSprites(_dotRadius * _devicePixelRatio);
+    }
+
+    const auto size = (QSizeF(viewport) * _devicePixelRatio).toSize();
+    const auto need = size.boundedTo(_extent);
+    if (_dirty || _image.width() < need.width() || _image.height() < need.height()) {
+        rasterise(size, _devicePixelRatio);
+        _dirty = false;
+    }
+
+    return _image;
+}
+
+void SplatRenderer::buildSprites(qreal radius)
+{
+    /// the centre is at most (1 - 1/phases) right of and below the middle pixel's corner.
+    const auto reach = i32(std::ceil(radius));
+    const auto r2    = radius * radius;
+    _spriteSize      = 2 * reach + 1;
+
+    for (i32 phase = 0; phase < phases * phases; ++phase) {
+        const auto cx = reach + qreal(phase % phases) / phases;
+        const auto cy = reach + qreal(phase / phases) / phases;
+
+        auto& sprite = _sprites[phase];
+        sprite.assign(_spriteSize * _spriteSize, 0);
+
+        for (i32 row = 0; row < _spriteSize; ++row) {
+            for (i32 col = 0; col < _spriteSize; ++col) {
+                i32 inside = 0;
+                for (i32 sy = 0; sy < samples; ++sy) {
+                    for (i32 sx = 0; sx < samples; ++sx) {
+                        const auto dx = col + (sx + 0.5) / samples - cx;
+                        const auto dy = row + (sy + 0.5) / samples - cy;
+                        inside += dx*dx + dy*dy <= r2;
+                    }
+                }
+                sprite[row * _spriteSize + col] = uchar((inside * 255 + samples * samples / 2) / (samples * samples));
+            }
+        }
+    }
+}
+
+void SplatRenderer::rasterise(const QSize& size, qreal devicePixelRatio)
+{
+    const auto points = _frame.points();
+    const auto scale  = _scale * devicePixelRatio;
+    const auto reach  = _spriteSize / 2;
+    const auto side   = _spriteSize;
+
+    /// place every dot on the pixel grid, rounded to the nearest phase.
+    _splats.resize(points.size());
+    std::mutex mutex;
+    QSize reached;
+
+    _pool.parallelFor(points.size(), [&](std::size_t begin, std::size_t end) {
+        QSize partial;
+        for (auto i = begin; i < end; ++i) {
+            const auto x  = points[i].x * scale;
+            const auto y  = points[i].y * scale;
+            auto px       = std::floor(x);
+            auto py       = std::floor(y);
+            auto qx       = i32((x - px) * phases + 0.5);
+            auto qy       = i32((y - py) * phases + 0.5);
+            if (qx == phases) { px += 1; qx = 0; }
+            if (qy == phases) { py += 1; qy = 0; }
+
+            _splats[i] = {i32(px) - reach, i32(py) - reach, u32(qy * phases + qx)};
+            partial    = partial.expandedTo({_splats[i].x + side, _splats[i].y + side});
+        }
+
+        std::lock_guard lock(mutex);
+        reached = reached.expandedTo(partial);
+    });
+
+    _extent = reached;
+
+    const auto target = size.boundedTo(_extent);
+    if (target.isEmpty()) {
+        _image = QImage();
+        return;
+    }
+
+    const auto width  = target.width();
+    const auto height = target.height();
+    const auto bands  = (height + bandHeight - 1) / bandHeight;
+
+    /// bin the dots by the bands of rows they touch; one that straddles a border is
+    /// drawn by both bands, each clipped to its own rows.
+    auto visibleBands = [&](const Splat& s) {
+        if (s.x + side <= 0 || s.x >= width || s.y + side <= 0 || s.y >= height) {
+            return std::pair{1, 0};
+        }
+        return std::pair{std::max(s.y, 0) / bandHeight, std::min(s.y + side - 1, height - 1) / bandHeight};
+    };
+
+    _bandStarts.assign(bands + 1, 0);
+    for (const auto& splat : _splats) {
+        const auto [first, last] = visibleBands(splat);
+        for (auto b = first; b <= last; ++b) {
+            _bandStarts[b + 1]++;
+        }
+    }
+    for (i32 b = 0; b < bands; ++b) {
+        _bandStarts[b + 1] += _bandStarts[b];
+    }
+
+    _binned.resize(_bandStarts.back());
+    auto fill = std::vector<u32>(_bandStarts.begin(), _bandStarts.end() - 1);
+    for (const auto& splat : _splats) {
+        const auto [first, last] = visibleBands(splat);
+        for (auto b = first; b <= last; ++b) {
+            _binned[fill[b]++] = splat;
+        }
+    }
+
+    if (_image.size() != target) {
+        _image = QImage(target, QImage::Format_Grayscale8);
+    }
+    _image.fill(255);
+    _image.setDevicePixelRatio(devicePixelRatio);
+
+    auto* bits        = _image.bits();
+    const auto stride = _image.bytesPerLine();
+
+    _pool.parallelFor(bands, [&](std::size_t firstBand, std::size_t lastBand) {
+        for (auto b = i32(firstBand); b < i32(lastBand); ++b) {
+            const auto rowBegin = b * bandHeight;
+            const auto rowEnd   = std::min(rowBegin + bandHeight, height);
+
+            for (auto k = _bandStarts[b]; k < _bandStarts[b + 1]; ++k) {
+                const auto& splat  = _binned[k];
+                const auto& sprite = _sprites[splat.phase];
+
+                const auto r0 = std::max(splat.y, rowBegin);
+                const auto r1 = std::min(splat.y + side, rowEnd);
+                const auto c0 = std::max(splat.x, 0);
+                const auto c1 = std::min(splat.x + side, width);
+
+                for (auto row = r0; row < r1; ++row) {
+                    auto* line        = bits + row * stride;
+                    const auto* cover = sprite.data() + (row - splat.y) * side;
+                    for (auto col = c0; col < c1; ++col) {
+                        line[col] = over(line[col], cover[col - splat.x]);
+                    }
+                }
+            }
+        }
+    });
+}
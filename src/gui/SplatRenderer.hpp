@@ -0,0 +1,75 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#pragma once
+
+#include "core/PointFrame.hpp"
+#include "core/ThreadPool.hpp"
+
+#include <QImage>
+
+#include <array>
+#include <vector>
+
+
+namespace gui
+{
+    /// rasterises a PointFrame into a greyscale image by compositing precomputed antialiased
+    /// dot sprites, one band of rows per task across a thread pool.
+    ///
+    /// the image is kept until the points, the scale, the dot radius or the device pixel ratio
+    /// change, or the viewport grows past it, so repaints in between only blit it.
+    class SplatRenderer
+    {
+    public:
+        /// zero threads means one per hardware thread.
+        explicit SplatRenderer(u32 threads = 0);
+
+        void setFrame(const core::PointFrame& frame);
+
+        /// logical pixels per unit of the points.
+        void setScale(qreal scale);
+
+        /// dot radius in logical pixels.
+        void setDotRadius(qreal radius);
+
+        /// black dots on white covering the part of viewport (in logical pixels, anchored at the
+        /// origin) the points reach; re-rasterised only if anything it depends on changed.
+        const QImage& image(const QSize& viewport, qreal devicePixelRatio = 1);
+
+    private:
+        /// subpixel positions per axis a sprite is precomputed for.
+        static constexpr i32 phases = 4;
+
+        /// rows composited by one task.
+        static constexpr i32 bandHeight = 32;
+
+        /// where a dot lands: the top-left pixel of its sprite and the sprite's phase.
+        struct Splat
+        {
+            i32 x;
+            i32 y;
+            u32 phase;
+        };
+
+        void buildSprites(qreal radius);
+
+        void rasterise(const QSize& size, qreal devicePixelRatio);
+
+        core::ThreadPool _pool;
+        core::PointFrame _frame;
+        qreal _scale{1};
+        qreal _dotRadius{1};
+        qreal _devicePixelRatio{0};
+        bool _dirty{true};
+
+        i32 _spriteSize{0};
+        std::array<std::vector<uchar>, phases * phases> _sprites; ///< coverage, row-major, per phase.
+        std::vector<Splat> _splats;
+        std::vector<u32> _bandStarts;
+        std::vector<Splat> _binned;     ///< _splats grouped by band, in the order they are drawn.
+        QSize _extent;                  ///< device pixels the dots of _frame reach.
+        QImage _image;
+    };
+}
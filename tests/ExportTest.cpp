@@ -0,0 +1,138 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// writes points as SVG and SVGZ in both styles and as text, reads every file back and compares
+/// the positions with those written, to the precision of each format.
+
+
+#include "core/Export.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <zlib.h>
+
+#include <cmath>
+#include <print>
+#include <random>
+#include <regex>
+#include <string>
+
+
+using namespace core;
+
+namespace
+{
+    /// the content of a gzip stream; empty if it is not one.
+    std::string gunzip(const QByteArray& compressed)
+    {
+        z_stream stream{};
+        /// 15 window bits, plus 16 for a gzip wrapper, as Export writes.
+        if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+            return {};
+        }
+        stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+        stream.avail_in = uInt(compressed.size());
+
+        std::string text;
+        char chunk[1 << 14];
+        int status;
+        do {
+            stream.next_out  = reinterpret_cast<Bytef*>(chunk);
+            stream.avail_out = sizeof(chunk);
+            status = inflate(&stream, Z_NO_FLUSH);
+            text.append(chunk, sizeof(chunk) - stream.avail_out);
+        } while (status == Z_OK);
+        inflateEnd(&stream);
+
+        return status == Z_STREAM_END ? text : std::string();
+    }
+
+    std::string read(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        const auto bytes = file.readAll();
+        return path.endsWith(".svgz") ? gunzip(bytes) : bytes.toStdString();
+    }
+
+    /// the numbers of every match of pattern, two per point, against points scaled by scale.
+    bool positionsMatch(const std::string& text, const std::regex& pattern, const PointFrame& frame, f64 scale,
+                        f64 tolerance)
+    {
+        auto points = frame.points();
+        std::size_t i = 0;
+        auto passed = true;
+        for (auto it = std::sregex_iterator(text.begin(), text.end(), pattern); it != std::sregex_iterator(); ++it) {
+            if (i >= points.size()) {
+                return false;
+            }
+            const auto x = std::stod((*it)[1].str());
+            const auto y = std::stod((*it)[2].str());
+            passed &= std::abs(x - points[i].x * scale) <= tolerance && std::abs(y - points[i].y * scale) <= tolerance;
+            ++i;
+        }
+        return passed && i == points.size();
+    }
+
+    bool svgRoundTrips(const QTemporaryDir& dir, const PointFrame& frame, SvgStyle style, const char* suffix)
+    {
+        static const std::regex circle(R"re(<circle cx="([-0-9.]+)" cy="([-0-9.]+)")re");
+        static const std::regex move(R"(M([-0-9.]+) ([-0-9.]+)h0)");
+
+        constexpr f64 scale = 2.5;
+        const auto path = dir.filePath(QString("points") + suffix);
+
+        auto passed = writeSvg(path, frame, QSize(200, 100), scale, 1.5, style);
+        const auto text = read(path);
+        passed &= text.starts_with("<?xml") && text.ends_with("</svg>\n");
+        /// three decimals, of the position rounded to float.
+        passed &= positionsMatch(text, style == SvgStyle::Circles ? circle : move, frame, scale, 6e-4);
+
+        std::println("{} {}: {}", style == SvgStyle::Circles ? "circles" : "path", suffix, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    bool pointsRoundTrip(const QTemporaryDir& dir, const PointFrame& frame)
+    {
+        static const std::regex line(R"(([-0-9.]+) ([-0-9.]+)\n)");
+
+        const auto path = dir.filePath("points.txt");
+        auto passed = writePoints(path, frame);
+        /// four decimals.
+        passed &= positionsMatch(read(path), line, frame, 1, 6e-5);
+
+        std::println("points: {}", passed ? "ok" : "FAILED");
+        return passed;
+    }
+}
+
+int main()
+{
+    const QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::println("cannot create a temporary directory");
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<f32> x(0, 200);
+    std::uniform_real_distribution<f32> y(0, 100);
+    auto points = std::make_shared<PointFrame::Points>();
+    for (u32 i = 0; i < 5000; ++i) {
+        points->emplace_back(x(random), y(random));
+    }
+    const PointFrame frame(std::move(points));
+
+    auto passed = true;
+    for (const auto* suffix : {".svg", ".svgz"}) {
+        passed &= svgRoundTrips(dir, frame, SvgStyle::Circles, suffix);
+        passed &= svgRoundTrips(dir, frame, SvgStyle::Path, suffix);
+    }
+    passed &= pointsRoundTrip(dir, frame);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// checks the FFT force field against the direct O(P^2) sum the kernel computes, on grids of
+/// odd and mixed sizes, including one that is given twice so that the cached transform is reused.
+
+
+#include "core/ForceField.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <print>
+#include <random>
+
+
+using namespace core;
+
+namespace
+{
+    std::vector<f64> directField(const std::vector<f32>& charges, u32 width, u32 height)
+    {
+        auto field = std::vector<f64>(std::size_t(2) * width * height);
+        for (u32 p = 0; p < width * height; ++p) {
+            for (u32 q = 0; q < width * height; ++q) {
+                const auto g = coulomb(f64(i32(q % width) - i32(p % width)), f64(i32(q / width) - i32(p / width)));
+                field[2*p    ] += charges[q] * g.x;
+                field[2*p + 1] += charges[q] * g.y;
+            }
+        }
+        return field;
+    }
+
+    /// largest difference relative to the largest force.
+    bool matches(FieldConvolution& convolution, u32 width, u32 height, u32 seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<f32> uniform(0, 1);
+
+        auto charges = std::vector<f32>(std::size_t(width) * height);
+        std::ranges::generate(charges, [&] { return uniform(random); });
+
+        const auto fft    = convolution.apply(charges, width, height);
+        const auto direct = directField(charges, width, height);
+
+        f64 largest = 0;
+        f64 error   = 0;
+        for (std::size_t i = 0; i < direct.size(); ++i) {
+            largest = std::max(largest, std::abs(direct[i]));
+            error   = std::max(error, std::abs(direct[i] - f64(fft[i])));
+        }
+
+        const auto relative = error / std::max(largest, 1e-30);
+        const auto passed   = relative < 1e-5;
+        std::println("{}x{}: relative error {:.3g} {}", width, height, relative, passed ? "ok" : "FAILED");
+        return passed;
+    }
+}
+
+int main()
+{
+    FieldConvolution convolution(coulomb);
+
+    auto passed = true;
+    passed &= matches(convolution, 13, 9, 1);
+    passed &= matches(convolution, 7, 16, 2);
+    passed &= matches(convolution, 1, 5, 3);
+    passed &= matches(convolution, 31, 1, 4);
+    passed &= matches(convolution, 13, 9, 5);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// checks point sets on disk: a stored set loads back with the same header and bitwise the same
+/// points, a missing, truncated or altered file is rejected, and the image fingerprint changes
+/// with the values and the dimensions.
+
+
+#include "core/PointSet.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cstring>
+#include <print>
+#include <random>
+
+
+using namespace core;
+
+namespace
+{
+    std::vector<compute::float2_> randomPoints(u32 count)
+    {
+        std::mt19937 random(count);
+        std::uniform_real_distribution<f32> uniform(0, 1000);
+
+        std::vector<compute::float2_> points;
+        for (u32 i = 0; i < count; ++i) {
+            points.emplace_back(uniform(random), uniform(random));
+        }
+        return points;
+    }
+
+    bool infoMatches(const PointSetInfo& a, const PointSetInfo& b)
+    {
+        return a.width == b.width && a.height == b.height && a.radius == b.radius && a.iteration == b.iteration &&
+               a.maxIterations == b.maxIterations && a.seed == b.seed && a.image == b.image;
+    }
+
+    bool roundTrips(const QTemporaryDir& dir, u32 count)
+    {
+        const PointSetInfo info{640, 480, 1.75f, 123, 5000, 0xfedcba9876543210ull, 0x0123456789abcdefull};
+        const auto points = randomPoints(count);
+        const auto path   = dir.filePath("roundtrip.ehp");
+
+        auto passed = PointSet::store(path, info, points);
+        const auto set = PointSet::load(path);
+        passed &= set.has_value();
+        if (set) {
+            passed &= infoMatches(set->info(), info);
+            passed &= set->points().size() == points.size();
+            passed &= points.empty() ||
+                      std::memcmp(set->points().data(), points.data(), points.size() * sizeof(compute::float2_)) == 0;
+            passed &= set->frame().points().size() == points.size();
+        }
+
+        std::println("round trip of {} points: {}", count, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    /// stores a valid set, lets alter change the file, and expects load to reject it.
+    template <typename Alter>
+    bool rejects(const QTemporaryDir& dir, const char* name, Alter alter)
+    {
+        const auto path = dir.filePath(QString(name) + ".ehp");
+        auto passed = PointSet::store(path, {}, randomPoints(100));
+
+        QFile file(path);
+        passed &= file.open(QIODevice::ReadWrite);
+        alter(file);
+        file.close();
+        passed &= !PointSet::load(path).has_value();
+
+        std::println("{} file rejected: {}", name, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    bool rejectsInvalid(const QTemporaryDir& dir)
+    {
+        auto passed = !PointSet::load(dir.filePath("missing.ehp")).has_value();
+        std::println("missing file rejected: {}", passed ? "ok" : "FAILED");
+
+        passed &= rejects(dir, "truncated", [](QFile& file) { file.resize(file.size() - 4); });
+        passed &= rejects(dir, "extended", [](QFile& file) {
+            file.seek(file.size());
+            file.write(QByteArray(8, '\0'));
+        });
+        passed &= rejects(dir, "headerless", [](QFile& file) { file.resize(20); });
+        passed &= rejects(dir, "foreign", [](QFile& file) { file.write("PNG"); });
+        passed &= rejects(dir, "newer", [](QFile& file) {
+            /// the version follows the eight bytes of the magic.
+            const u32 version = PointSet::version + 1;
+            file.seek(8);
+            file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        });
+        return passed;
+    }
+
+    bool fingerprintDistinguishes()
+    {
+        std::vector<f32> values(12, 0.5f);
+        const auto base = PointSet::fingerprint(values, 4, 3);
+
+        auto passed = PointSet::fingerprint(values, 4, 3) == base;
+        passed &= PointSet::fingerprint(values, 3, 4) != base;
+        values[7] = 0.5001f;
+        passed &= PointSet::fingerprint(values, 4, 3) != base;
+
+        std::println("fingerprint: {}", passed ? "ok" : "FAILED");
+        return passed;
+    }
+}
+
+int main()
+{
+    const QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::println("cannot create a temporary directory");
+        return 1;
+    }
+
+    auto passed = true;
+    passed &= roundTrips(dir, 0);
+    passed &= roundTrips(dir, 100003);
+    passed &= rejectsInvalid(dir);
+    passed &= fingerprintDistinguishes();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// checks the Barnes-Hut quadtree: its leaves cover every particle exactly once, each node
+/// holds the charge and centre of its particles, and with an opening angle of 0, which opens
+/// every node, an iteration moves the particles as the exact O(N^2) sum does.
+
+
+#include "core/NativeBackend.hpp"
+#include "core/QuadTree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <print>
+#include <random>
+
+
+using namespace core;
+
+namespace
+{
+    std::vector<compute::float2_> randomPoints(u32 count, f32 extent, u32 seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<f32> uniform(1, extent - 1);
+
+        std::vector<compute::float2_> points;
+        for (u32 i = 0; i < count; ++i) {
+            points.emplace_back(uniform(random), uniform(random));
+        }
+        return points;
+    }
+
+    bool structureMatches(const std::vector<compute::float2_>& points)
+    {
+        QuadTree tree;
+        tree.build(points, 4);
+
+        const auto& nodes = tree.nodes();
+        const auto& links = tree.links();
+        const auto& tp    = tree.points();
+
+        /// the leaves, visited in order, cover [0, n) without gaps or overlaps.
+        auto passed = tp.size() == points.size();
+        u32 covered = 0;
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            const auto& link = links[i];
+            if (link.x == 0) {
+                passed &= link.z == covered;
+                covered = link.w;
+            }
+
+            f64 cx = 0;
+            f64 cy = 0;
+            for (auto j = link.z; j < link.w; ++j) {
+                cx += tp[j].x;
+                cy += tp[j].y;
+            }
+            const auto charge = f64(link.w - link.z);
+            passed &= nodes[i].z == f32(charge);
+            passed &= std::abs(nodes[i].x - cx / charge) < 1e-3 && std::abs(nodes[i].y - cy / charge) < 1e-3;
+        }
+        passed &= covered == points.size();
+
+        /// the tree only reorders the particles.
+        auto less = [](const auto& a, const auto& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); };
+        auto sorted    = points;
+        auto reordered = tp;
+        std::ranges::sort(sorted, less);
+        std::ranges::sort(reordered, less);
+        passed &= std::ranges::equal(sorted, reordered, [](const auto& a, const auto& b) {
+            return a.x == b.x && a.y == b.y;
+        });
+
+        std::println("quadtree of {} particles, {} nodes: {}", points.size(), nodes.size(), passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    /// largest difference of the moves relative to the largest exact move.
+    bool openedTreeMatchesExact(const std::vector<compute::float2_>& points, u32 extent)
+    {
+        NativeBackend backend;
+        backend.setPrecision(Stage::Repulsion, Precision::Double);
+        backend.setForceField(std::vector<f32>(std::size_t(2) * extent * extent), extent, extent);
+        const Step step{{extent - 1.f, extent - 1.f}, 0.5f};
+
+        std::vector<compute::float2_> exact;
+        backend.setParticles(points);
+        backend.iterateExact(step);
+        backend.particles(exact);
+
+        QuadTree tree;
+        tree.build(points);
+        std::vector<compute::float2_> barnesHut;
+        backend.setParticles(points);
+        backend.iterateBarnesHut(step, tree, 0);
+        backend.particles(barnesHut);
+
+        f64 largest = 0;
+        f64 error   = 0;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            largest = std::max({largest, std::abs(f64(exact[i].x) - points[i].x),
+                                std::abs(f64(exact[i].y) - points[i].y)});
+            error   = std::max({error, std::abs(f64(exact[i].x) - barnesHut[i].x),
+                                std::abs(f64(exact[i].y) - barnesHut[i].y)});
+        }
+
+        const auto relative = error / std::max(largest, 1e-30);
+        const auto passed   = largest > 0 && relative < 1e-4;
+        std::println("theta 0 against the exact sum, {} particles: relative error {:.3g} {}", points.size(), relative,
+                     passed ? "ok" : "FAILED");
+        return passed;
+    }
+}
+
+int main()
+{
+    auto passed = true;
+    passed &= structureMatches(randomPoints(3000, 64, 1));
+    passed &= openedTreeMatchesExact(randomPoints(2000, 64, 2), 64);
+    passed &= openedTreeMatchesExact(randomPoints(257, 16, 3), 16);
+
+    return passed ? 0 : 1;
+}
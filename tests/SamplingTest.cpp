@@ -0,0 +1,163 @@
+/// Copyright (C) 2025 Arlen Avakian
+/// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+/// checks the random streams particles are placed and shaken with: the host Philox against the
+/// known-answer vectors of its authors, the frequencies the alias table draws pixels with
+/// against their weights, and, if there is an OpenCL device, the kernels against the host.
+
+
+#include "core/AliasTable.hpp"
+#include "core/NativeBackend.hpp"
+#include "core/OpenClBackend.hpp"
+#include "core/Philox.hpp"
+#include "core/eh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <print>
+
+
+using namespace core;
+
+namespace
+{
+    /// Philox4x32-10 known-answer tests of Random123.
+    bool philoxMatchesReference()
+    {
+        struct Vector
+        {
+            PhiloxCounter counter;
+            PhiloxKey key;
+            PhiloxCounter expected;
+        };
+        const Vector vectors[] = {
+            {{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+            {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+             {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+            {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+             {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+        };
+
+        auto passed = true;
+        for (const auto& vector : vectors) {
+            passed &= philox(vector.counter, vector.key) == vector.expected;
+        }
+        std::println("philox known answers: {}", passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    /// seeds particles on a one-row density, so that a particle's column is the pixel drawn,
+    /// and compares how often every pixel was drawn with its weight, within five standard
+    /// deviations; a pixel of weight 0 must never be drawn.
+    bool aliasFrequenciesMatchWeights()
+    {
+        const std::vector<f32> weights = {1, 0, 2, 3, 10, 0.5f, 7, 0, 4.5f};
+        constexpr u32 count = 200000;
+
+        AliasTable table;
+        table.build(weights);
+
+        NativeBackend backend;
+        backend.setDensity(table, u32(weights.size()));
+        backend.seedParticles(count, 42);
+
+        std::vector<compute::float2_> points;
+        backend.particles(points);
+
+        auto drawn = std::vector<u32>(weights.size());
+        for (const auto& p : points) {
+            drawn[std::min(std::size_t(p.x), weights.size() - 1)]++;
+        }
+
+        f64 total = 0;
+        for (auto w : weights) { total += w; }
+
+        auto passed = true;
+        for (std::size_t i = 0; i < weights.size(); ++i) {
+            const auto p        = weights[i] / total;
+            const auto expected = count * p;
+            const auto bound    = 5 * std::sqrt(count * p * (1 - p));
+            const auto ok       = weights[i] == 0 ? drawn[i] == 0 : std::abs(drawn[i] - expected) <= bound;
+            if (!ok) {
+                std::println("pixel {}: drawn {} times, expected {:.0f} +- {:.0f}", i, drawn[i], expected, bound);
+            }
+            passed &= ok;
+        }
+        std::println("alias table frequencies: {}", passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    f32 largestDifference(const std::vector<compute::float2_>& a, const std::vector<compute::float2_>& b)
+    {
+        if (a.size() != b.size()) {
+            return std::numeric_limits<f32>::infinity();
+        }
+        f32 largest = 0;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            largest = std::max({largest, std::abs(a[i].x - b[i].x), std::abs(a[i].y - b[i].y)});
+        }
+        return largest;
+    }
+
+    /// seeds and shakes the same particles on both backends; seeding is exact in float, the
+    /// shake may be contracted to a multiply-add by the OpenCL compiler.
+    bool kernelsMatchHost(const std::shared_ptr<Device>& device)
+    {
+        auto darkness = std::vector<f32>(37 * 23);
+        for (std::size_t i = 0; i < darkness.size(); ++i) {
+            darkness[i] = f32((i * 7919) % 101) / 100.f;
+        }
+        AliasTable table;
+        table.build(darkness);
+
+        NativeBackend host;
+        OpenClBackend kernels(device);
+
+        std::vector<compute::float2_> expected;
+        std::vector<compute::float2_> actual;
+        auto passed = true;
+
+        for (Backend* backend : {static_cast<Backend*>(&host), static_cast<Backend*>(&kernels)}) {
+            backend->setDensity(table, 37);
+            backend->seedParticles(10000, 0x123456789abcdefull);
+        }
+        host.particles(expected);
+        kernels.particles(actual);
+        const auto seeded = largestDifference(expected, actual);
+        std::println("seedParticles, kernel against host: largest difference {} {}", seeded,
+                     seeded == 0 ? "ok" : "FAILED");
+        passed &= seeded == 0;
+
+        host.shake(7, 3, 0.25f);
+        kernels.shake(7, 3, 0.25f);
+        host.particles(expected);
+        kernels.particles(actual);
+        const auto shaken = largestDifference(expected, actual);
+        std::println("shake, kernel against host: largest difference {} {}", shaken, shaken <= 1e-4f ? "ok" : "FAILED");
+        passed &= shaken <= 1e-4f;
+
+        return passed;
+    }
+}
+
+int main()
+{
+    auto passed = true;
+    passed &= philoxMatchesReference();
+    passed &= aliasFrequenciesMatchWeights();
+
+    std::shared_ptr<Device> device;
+    try {
+        device = selectDevice(BackendType::OpenCL);
+    } catch (const std::exception& e) {
+        std::println("no OpenCL device, kernels not checked: {}", e.what());
+    }
+    if (device) {
+        passed &= kernelsMatchHost(device);
+    }
+
+    return passed ? 0 : 1;
+}